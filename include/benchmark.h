@@ -0,0 +1,30 @@
+#ifndef BENCHMARK_H_INCLUDED
+#define BENCHMARK_H_INCLUDED
+
+#include <stdint.h>
+
+#define BENCHMARK_DEFAULT_FRAMES 600
+#define BENCHMARK_DEFAULT_WARMUP 60
+#define BENCHMARK_FRAME_STEP (1.0f / 60.0f) // fiksni delta_time, putanja ne zavisi od brzine masine
+#define BENCHMARK_PATH_DURATION 20.0f      // sekundi (fiksnog vremena) za jedan krug putanje
+#define BENCHMARK_DEFAULT_TOLERANCE 0.10f
+
+// ./main.out --benchmark [--frames N] [--warmup N] [--size WxH] [--seed N]
+//            [--path file] [--out file.json] [--baseline file.json] [--tolerance 0.1]
+typedef struct {
+    int frames;            // mereni frejmovi
+    int warmup_frames;     // frejmovi pre merenja (upload, kesevi drajvera)
+    int width, height;
+    uint32_t seed;
+    const char *path_file; // snimljena putanja, NULL = ugradjeni spline
+    const char *output_path;
+    const char *baseline_path;
+    float tolerance;       // dozvoljeno usporenje p50/p99 u odnosu na baseline
+} BenchmarkConfig;
+
+// vraca 1 ako argumenti traze benchmark
+int benchmark_parse_args(int argc, char *argv[], BenchmarkConfig *config);
+// offscreen render bez unosa, JSON na stdout (i u output_path); vraca exit kod
+int benchmark_run(const BenchmarkConfig *config);
+
+#endif // BENCHMARK_H_INCLUDED
@@ -3,6 +3,15 @@
 
 #include <rafgl.h>
 
+#define CAMERA_PATH_MAX_POINTS 64
+
+// zatvorena Catmull-Rom putanja, kamera je obidje za duration sekundi
+typedef struct {
+    vec3_t points[CAMERA_PATH_MAX_POINTS];
+    int count;
+    float duration;
+} CameraPath;
+
 typedef struct {
     vec3_t position;     // Where the camera is
     vec3_t front;        // Direction camera is looking
@@ -22,6 +31,10 @@ typedef struct {
     
     mat4_t view;
     mat4_t projection;
+
+    // kad je postavljena, camera_update prati putanju umesto unosa
+    const CameraPath *path;
+    float path_time;
 } Camera;
 
 void camera_init(Camera *camera, float aspect_ratio);
@@ -29,4 +42,9 @@ void camera_update(Camera *camera, float delta_time, rafgl_game_data_t *game_dat
 mat4_t camera_get_mvp(Camera *camera);
 vec3_t camera_get_position(const Camera *camera);
 
+void camera_set_path(Camera *camera, const CameraPath *path);
+vec3_t camera_path_sample(const CameraPath *path, float t);
+// "x y z" po redu, # za komentare; vraca 0 ako je ucitano bar 4 tacke
+int camera_path_load(CameraPath *path, const char *file_path, float duration);
+
 #endif // CAMERA_H_INCLUDED
@@ -0,0 +1,39 @@
+#ifndef FRUSTUM_H_INCLUDED
+#define FRUSTUM_H_INCLUDED
+
+#include <rafgl.h>
+
+// ravan a*x + b*y + c*z + d = 0, normala gleda ka unutrasnjosti frustuma
+typedef struct {
+    float a, b, c, d;
+} FrustumPlane;
+
+typedef struct {
+    FrustumPlane planes[6]; // levo, desno, dole, gore, near, far
+} Frustum;
+
+// koliko objekata je nacrtano/odbaceno u poslednjem frejmu
+typedef struct {
+    int drawn;
+    int culled;
+} CullCounter;
+
+typedef enum {
+    FRUSTUM_OUTSIDE = 0,
+    FRUSTUM_INTERSECTS,
+    FRUSTUM_INSIDE      // deca ovakvog cvora ne moraju ponovo da se testiraju
+} FrustumClass;
+
+// ravni se vade direktno iz projection * view (npr. camera_get_mvp)
+void frustum_from_matrix(Frustum *frustum, mat4_t view_projection);
+int frustum_test_aabb(const Frustum *frustum, vec3_t min, vec3_t max);
+FrustumClass frustum_classify_aabb(const Frustum *frustum, vec3_t min, vec3_t max);
+int frustum_test_sphere(const Frustum *frustum, vec3_t center, float radius);
+
+static inline void cull_counter_reset(CullCounter *counter)
+{
+    counter->drawn = 0;
+    counter->culled = 0;
+}
+
+#endif // FRUSTUM_H_INCLUDED
@@ -3,10 +3,27 @@
 
 #include <GLFW/glfw3.h>
 #include <rafgl.h>
+#include <frustum.h>
+#include <camera.h>
+
+// brojaci iz poslednjeg nacrtanog frejma
+typedef struct {
+    CullCounter patches;  // patchovi fiksnog terena ili streaming chunkovi
+    CullCounter trees;
+    CullCounter water;
+    int terrain_triangles;
+    int terrain_draw_calls;
+    int shadow_draw_calls; // sve kaskade, teren i drvece
+    int draw_calls;       // svi GL draw pozivi u frejmu
+    float overdraw;       // sencenih fragmenata terena i drveca po pikselu, frejm ili dva unazad
+} RenderStats;
 
 void main_state_init(GLFWwindow *window, void *args, int width, int height);
 void main_state_update(GLFWwindow *window, float delta_time, rafgl_game_data_t *game_data, void *args);
 void main_state_render(GLFWwindow *window, void *args);
 void main_state_cleanup(GLFWwindow *window, void *args);
+const RenderStats *main_state_render_stats(void);
+// NULL vraca kameru na unos sa tastature i misa
+void main_state_set_camera_path(const CameraPath *path);
 
 #endif // MAIN_STATE_H_INCLUDED
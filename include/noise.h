@@ -2,13 +2,46 @@
 #define NOISE_H_INCLUDED
 
 #include <stdlib.h>
+#include <stdint.h>
 #include <math.h>
 
 #define TABLE_SIZE 256
 #define PERM_MASK 255
 
+// fbm_row i fbm se razlikuju najvise za ovoliko (apsolutno), SIMD putanja
+// racuna istim redosledom operacija pa je razlika obicno 0
+#define FBM_ROW_TOLERANCE 1e-5f
+
+// PCG32, mali i brz generator, svaki kontekst ima svoj
+typedef struct {
+    uint64_t state;
+    uint64_t inc;
+} NoiseRng;
+
+void noise_rng_seed(NoiseRng *rng, uint64_t seed, uint64_t stream);
+uint32_t noise_rng_next(NoiseRng *rng);
+int noise_rng_below(NoiseRng *rng, int bound);          // [0, bound)
+float noise_rng_float(NoiseRng *rng);                   // [0, 1)
+float noise_rng_range(NoiseRng *rng, float min_value, float max_value);
+
+// sopstvena permutaciona tabela, posle init-a je samo za citanje pa je
+// vise niti moze koristiti istovremeno
+typedef struct {
+    int perm[TABLE_SIZE * 2];
+    uint32_t seed;
+} NoiseContext;
+
+void noise_context_init(NoiseContext *ctx, uint32_t seed);
+float perlin2d_ctx(const NoiseContext *ctx, float x, float y);
+float fbm_ctx(const NoiseContext *ctx, float x, float y, int octaves);
+// fbm za ceo red: out[i] = fbm_ctx(ctx, xs[i], y, octaves)
+// koristi AVX2/SSE2 kernel kada ga procesor podrzava, inace skalarni
+void fbm_row_ctx(const NoiseContext *ctx, const float *xs, float y, int n, int octaves, float *out);
+
+// stari API radi nad globalnim kontekstom koji noise_init seeduje sa rand()
 void noise_init(void);
 float perlin2d(float x, float y);
 float fbm(float x, float y, int octaves);
+void fbm_row(const float *xs, float y, int n, int octaves, float *out);
 
 #endif // NOISE_H_INCLUDED
@@ -0,0 +1,69 @@
+#ifndef PROFILER_H_INCLUDED
+#define PROFILER_H_INCLUDED
+
+#include <glad/glad.h>
+
+// imenovani delovi frejma; CPU vreme uvek, GPU vreme preko GL_TIME_ELAPSED
+// upita (samo za delove koji crtaju), redom kojim se crtaju
+typedef enum {
+    PROFILE_UPDATE,
+    PROFILE_SHADOW0,  // po jedna za svaku kaskadu senki (SHADOW_MAX_CASCADES)
+    PROFILE_SHADOW1,
+    PROFILE_SHADOW2,
+    PROFILE_SHADOW3,
+    PROFILE_PREPASS,  // depth pre-pass terena i drveca, prazno kad je iskljucen
+    PROFILE_TERRAIN,
+    PROFILE_TREES,
+    PROFILE_SKYBOX,
+    PROFILE_WATER,
+    PROFILE_SCOPE_COUNT
+} ProfileScope;
+
+#define PROFILER_HISTORY 240      // frejmova za min/avg/p99
+#define PROFILER_QUERY_BUFFERS 2  // rezultat se cita frejm kasnije, pa nema cekanja na GPU
+#define PROFILER_OVERLAY_REFRESH 15 // overlay se ponovo crta na svakih N frejmova
+
+typedef struct {
+    float min_ms;
+    float avg_ms;
+    float p99_ms;
+    int samples;
+} ProfileStats;
+
+void profiler_init(void);
+void profiler_begin(ProfileScope scope);
+void profiler_end(ProfileScope scope);
+// zatvara frejm: pokupi gotove GPU upite i pomeri istoriju
+void profiler_frame_end(void);
+void profiler_stats(ProfileScope scope, int gpu, ProfileStats *out);
+const char *profiler_scope_name(ProfileScope scope);
+
+void profiler_set_overlay(int visible);
+int profiler_overlay_visible(void);
+// crta tabelu preko trenutnog framebuffera (rafgl_raster_draw_string + trake)
+void profiler_draw_overlay(int width, int height);
+// frame,scope,cpu_ms,gpu_ms za sve frejmove u istoriji, vraca 0 ako je uspelo
+int profiler_dump_csv(const char *path);
+void profiler_cleanup(void);
+
+// faze pokretanja (wall-clock); mogu da se preklapaju i da rade na worker nitima,
+// nula je pocetak prve faze
+#define PROFILER_MAX_PHASES 32
+
+typedef struct {
+    const char *name;
+    double start_ms;
+    double end_ms;
+    int on_worker;
+} ProfilePhase;
+
+// vraca id za profiler_phase_end, bezbedno sa bilo koje niti
+int profiler_phase_begin(const char *name);
+void profiler_phase_end(int phase);
+int profiler_phase_count(void);
+const ProfilePhase *profiler_phase_get(int index);
+double profiler_phase_elapsed(void);
+// tabela svih faza i ukupno vreme
+void profiler_phase_report(void);
+
+#endif // PROFILER_H_INCLUDED
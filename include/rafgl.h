@@ -119,6 +119,14 @@ typedef struct _rafgl_list_t
     int count;
 } rafgl_list_t;
 
+typedef struct _rafgl_vec_t
+{
+    void *data;
+    int element_size;
+    int count;
+    int capacity;
+} rafgl_vec_t;
+
 
 typedef struct _rafgl_game_t
 {
@@ -169,8 +177,30 @@ typedef struct _rafgl_meshPUN_t
     unsigned int triangle_count;
     int loaded;
     char name[64];
+    vec3_t bounds_min, bounds_max;
+    /* indexed meshes draw index_count GL_UNSIGNED_INT indices with glDrawElements* */
+    int indexed;
+    unsigned int index_count;
 } rafgl_meshPUN_t;
 
+/* binary mesh cache file: header, vertex_count rafgl_vertexPUN_t, index_count GLuint indices */
+#define RAFGL_MESH_CACHE_MAGIC "RMSH"
+#define RAFGL_MESH_CACHE_VERSION 1
+#define RAFGL_MESH_CACHE_EXTENSION ".rmesh"
+
+typedef struct _rafgl_mesh_cache_header_t
+{
+    char magic[4];
+    uint32_t version;
+    uint64_t source_mtime;
+    uint64_t source_size;
+    uint64_t source_hash;
+    uint32_t vertex_count;
+    uint32_t index_count;
+    vec3_t bounds_min, bounds_max;
+    char name[64];
+} rafgl_mesh_cache_header_t;
+
 typedef struct _rafgl_framebuffer_simple_t
 {
     GLuint fbo_id, tex_id;
@@ -184,6 +214,13 @@ typedef struct  _rafgl_framebuffer_multitarget_t
     int width, height;
 } rafgl_framebuffer_multitarget_t;
 
+/* samo depth, tex_id je GL_TEXTURE_2D_ARRAY sa poredjenjem (sampler2DArrayShadow) */
+typedef struct _rafgl_framebuffer_depth_t
+{
+    GLuint fbo_id, tex_id;
+    int width, height, layers;
+} rafgl_framebuffer_depth_t;
+
 
 
 /* initializes the GLFW library, GLEW and the window. If full-screen mode is selected, width and hight are unused and the monitor resolution is used instead */
@@ -254,6 +291,14 @@ int rafgl_list_free(rafgl_list_t *list);
 int rafgl_list_show(rafgl_list_t *list, void (*fun)(void *data, int last));
 int rafgl_list_test(void);
 
+/* contiguous growable array, capacity doubles when full */
+int rafgl_vec_init(rafgl_vec_t *vec, int element_size);
+int rafgl_vec_reserve(rafgl_vec_t *vec, int capacity);
+int rafgl_vec_append(rafgl_vec_t *vec, const void *data);
+void* rafgl_vec_get(rafgl_vec_t *vec, int index);
+void rafgl_vec_clear(rafgl_vec_t *vec);
+void rafgl_vec_free(rafgl_vec_t *vec);
+
 /* random float in the range of [0, 1) */
 float randf(void);
 /* abs difference between two numbers */
@@ -308,12 +353,26 @@ void rafgl_log_fps(int b);
 
 void rafgl_meshPUN_init(rafgl_meshPUN_t *m);
 void rafgl_meshPUN_load_from_OBJ(rafgl_meshPUN_t *m, const char *obj_path);
+/* uses <obj_path>.rmesh when it is up to date with the OBJ, otherwise parses the OBJ and rewrites the cache */
 void rafgl_meshPUN_load_from_OBJ_offset(rafgl_meshPUN_t *m, const char *obj_path, vec3_t position_offset);
+/* CPU half of rafgl_meshPUN_load_from_OBJ_offset (cache or OBJ parse), needs no GL context and can run on
+   a worker thread; returns 0 on success, the caller uploads with rafgl_meshPUN_upload and frees both arrays */
+int rafgl_meshPUN_read_OBJ(rafgl_meshPUN_t *m, const char *obj_path, vec3_t position_offset,
+                           rafgl_vertexPUN_t **out_vertices, GLuint **out_indices);
+void rafgl_meshPUN_upload(rafgl_meshPUN_t *m, const rafgl_vertexPUN_t *vertices, const GLuint *indices);
+/* loads a binary mesh written by rafgl_meshPUN_build_cache, returns 0 on success */
+int rafgl_meshPUN_load_from_cache(rafgl_meshPUN_t *m, const char *cache_path, vec3_t position_offset);
+/* parses the OBJ and writes the binary mesh, needs no GL context */
+int rafgl_meshPUN_build_cache(const char *obj_path, const char *cache_path);
 void rafgl_meshPUN_load_cube(rafgl_meshPUN_t *m, float coord);
 void rafgl_meshPUN_load_terrain_from_heightmap(rafgl_meshPUN_t *m, float w, float h, const char *img_path, float height);
 
 rafgl_framebuffer_simple_t rafgl_framebuffer_simple_create(int w, int h);
 rafgl_framebuffer_multitarget_t rafgl_framebuffer_multitarget_create(int w, int h, int num_attachments);
+/* sloj se bira sa rafgl_framebuffer_depth_bind_layer pre crtanja */
+rafgl_framebuffer_depth_t rafgl_framebuffer_depth_create(int w, int h, int layers);
+void rafgl_framebuffer_depth_bind_layer(rafgl_framebuffer_depth_t *fb, int layer);
+void rafgl_framebuffer_depth_cleanup(rafgl_framebuffer_depth_t *fb);
 
 void rafgl_meshPUN_load_plane(rafgl_meshPUN_t *m, float w, float h, int wtiles, int htiles);
 
@@ -333,6 +392,13 @@ extern rafgl_pixel_rgb_t RAFGL_COLOUR_KEY;
 #define STB_IMAGE_WRITE_IMPLEMENTATION
 #include <stb_image_write.h>
 
+#include <sys/stat.h>
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
 /* rafgl core implementation */
 
 rafgl_pixel_rgb_t RAFGL_COLOUR_KEY;
@@ -415,8 +481,10 @@ FILE *__log_files[RAFGL_LOG_LEVELS];
 static float __rafgl_time_from_init = 0;
 void rafgl_log(int level, const char *format, ...)
 {
-    va_list args;
+    va_list args, file_args;
     va_start(args, format);
+    /* args can only be walked once */
+    va_copy(file_args, args);
     FILE* fd = __log_files[level];
     if(level == RAFGL_ERROR)
     {
@@ -430,7 +498,8 @@ void rafgl_log(int level, const char *format, ...)
         vprintf(format, args);
     }
 
-    vfprintf(fd, format, args);
+    if(fd) vfprintf(fd, format, file_args);
+    va_end(file_args);
     va_end(args);
 }
 
@@ -1441,6 +1510,57 @@ rafgl_framebuffer_multitarget_t rafgl_framebuffer_multitarget_create(int w, int
 
 }
 
+rafgl_framebuffer_depth_t rafgl_framebuffer_depth_create(int w, int h, int layers)
+{
+    rafgl_framebuffer_depth_t fb;
+    fb.width = w;
+    fb.height = h;
+    fb.layers = layers;
+
+    glGenTextures(1, &fb.tex_id);
+    glBindTexture(GL_TEXTURE_2D_ARRAY, fb.tex_id);
+    glTexImage3D(GL_TEXTURE_2D_ARRAY, 0, GL_DEPTH_COMPONENT24, w, h, layers, 0, GL_DEPTH_COMPONENT, GL_UNSIGNED_INT, NULL);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_COMPARE_MODE, GL_COMPARE_REF_TO_TEXTURE);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_COMPARE_FUNC, GL_LEQUAL);
+    /* van mape nema senke */
+    GLfloat border[4] = {1.0f, 1.0f, 1.0f, 1.0f};
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_BORDER);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_BORDER);
+    glTexParameterfv(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_BORDER_COLOR, border);
+    glBindTexture(GL_TEXTURE_2D_ARRAY, 0);
+
+    glGenFramebuffers(1, &fb.fbo_id);
+    glBindFramebuffer(GL_FRAMEBUFFER, fb.fbo_id);
+    glFramebufferTextureLayer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, fb.tex_id, 0, 0);
+    glDrawBuffer(GL_NONE);
+    glReadBuffer(GL_NONE);
+
+    if(glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
+	{
+	    rafgl_log(RAFGL_ERROR, "Failed to create framebuffer!\n");
+	}
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+
+    return fb;
+}
+
+void rafgl_framebuffer_depth_bind_layer(rafgl_framebuffer_depth_t *fb, int layer)
+{
+    glBindFramebuffer(GL_FRAMEBUFFER, fb->fbo_id);
+    glFramebufferTextureLayer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, fb->tex_id, 0, layer);
+    glViewport(0, 0, fb->width, fb->height);
+}
+
+void rafgl_framebuffer_depth_cleanup(rafgl_framebuffer_depth_t *fb)
+{
+    glDeleteFramebuffers(1, &fb->fbo_id);
+    glDeleteTextures(1, &fb->tex_id);
+    fb->fbo_id = 0;
+    fb->tex_id = 0;
+}
+
 rafgl_framebuffer_simple_t rafgl_framebuffer_simple_create(int w, int h)
 {
 
@@ -1488,6 +1608,10 @@ void rafgl_meshPUN_init(rafgl_meshPUN_t *m)
     m->vertex_count = 0;
     m->vao_id = 0;
     memset(m->name, 0, sizeof(m->name));
+    m->bounds_min = vec3(0.0f, 0.0f, 0.0f);
+    m->bounds_max = vec3(0.0f, 0.0f, 0.0f);
+    m->indexed = 0;
+    m->index_count = 0;
 }
 
 void rafgl_meshPUN_load_plane(rafgl_meshPUN_t *m, float w, float h, int wtiles, int htiles)
@@ -1783,207 +1907,271 @@ void rafgl_meshPUN_load_from_OBJ(rafgl_meshPUN_t *m, const char *obj_path)
     rafgl_meshPUN_load_from_OBJ_offset(m, obj_path, vec3(0.0f, 0.0f, 0.0f));
 }
 
-/* TODO: create cache system */
-void rafgl_meshPUN_load_from_OBJ_offset(rafgl_meshPUN_t *m, const char *obj_path, vec3_t position_offset)
+/* skips spaces and tabs, never crosses a line break */
+static const char* __obj_skip_blank(const char *p)
 {
-    if(m->loaded)
-    {
-        rafgl_log(RAFGL_WARNING, "Trying to load to already loaded mesh! Loading from [%s] to mesh taken by [%s]", obj_path, m->name);
-        return;
-    }
-    rafgl_list_t vertices, uv_coordinates, normals;
-    rafgl_list_init(&vertices, sizeof(vec3_t));
-    rafgl_list_init(&uv_coordinates, sizeof(vec3_t));
-    rafgl_list_init(&normals, sizeof(vec3_t));
-    vec3_t vectmp;
-
-    FILE *f = fopen(obj_path, "rt");
-    char line[256];
-
-
-    while(!feof(f))
-    {
-        fgets(line, 256, f);
-
-
-        if(line[0] == 'o' && line[1] == ' ')
-		{
-			strcpy(m->name, line + 2);
-			m->name[strlen(m->name) - 1] = '\0';
-		}
-
-		if(line[0] == 'v' && line[1] == ' ')
-		{
-			sscanf(line + 2, "%f%f%f", &(vectmp.x), &(vectmp.y), &(vectmp.z));
-			vectmp = v3_add(vectmp, position_offset);
-			rafgl_list_append(&vertices, &vectmp);
-		}
-		else if (line[0] == 'v' && line[1] == 't')
-		{
-			sscanf(line + 3, "%f%f", &(vectmp.x), &(vectmp.y));
-			vectmp.z = 0;
-			rafgl_list_append(&uv_coordinates, &vectmp);
-		}
-		else if (line[0] == 'v' && line[1] == 'n')
-		{
-			sscanf(line + 3, "%f%f%f", &(vectmp.x), &(vectmp.y), &(vectmp.z));
-			rafgl_list_append(&normals, &vectmp);
-		}
-		else if (line[0] == 'f')
-		{
-			break;
-		}
-
-    }
-
-    vec3_t *vertices_buffer, *uv_buffer, *normals_buffer;
+    while(*p == ' ' || *p == '\t') p++;
+    return p;
+}
 
-    vertices_buffer = malloc(vertices.count * sizeof(vec3_t));
-    uv_buffer = malloc(uv_coordinates.count * sizeof(vec3_t));
-    normals_buffer = malloc(normals.count * sizeof(vec3_t));
+static const char* __obj_next_line(const char *p)
+{
+    while(*p && *p != '\n') p++;
+    if(*p == '\n') p++;
+    return p;
+}
 
-    vec3_t *vb1, *vb2, *vb3;
-    int o1 = 0, o2 = 0, o3 = 0;
-    while((vb1 = rafgl_list_get(&vertices, 0)) != NULL && (vb2 = rafgl_list_get(&uv_coordinates, 0)) != NULL && (vb3 = rafgl_list_get(&normals, 0)) != NULL)
-    {
-        vertices_buffer[o1++] = *vb1;
-        uv_buffer[o2++] = *vb2;
-        normals_buffer[o3++] = *vb3;
-        rafgl_list_remove(&vertices, 0);
-        rafgl_list_remove(&uv_coordinates, 0);
-        rafgl_list_remove(&normals, 0);
-    }
+static int __obj_at_line_end(const char *p)
+{
+    return *p == '\0' || *p == '\n' || *p == '\r' || *p == '#';
+}
 
-    while((vb1 = rafgl_list_get(&vertices, 0)) != NULL)
+/* reads up to count floats from the current line, missing ones are left as 0 */
+static const char* __obj_parse_floats(const char *p, float *out, int count)
+{
+    int i;
+    char *end;
+    for(i = 0; i < count; i++)
     {
-        vertices_buffer[o1++] = *vb1;
-        rafgl_list_remove(&vertices, 0);
+        out[i] = 0.0f;
+        p = __obj_skip_blank(p);
+        if(__obj_at_line_end(p)) continue;
+        out[i] = strtof(p, &end);
+        if(end == p) break;
+        p = end;
     }
+    return p;
+}
 
-    while((vb1 = rafgl_list_get(&uv_coordinates, 0)) != NULL)
+/* one face corner: v, v/t, v//n or v/t/n, negative indices are relative to the end. 0 = missing */
+static const char* __obj_parse_corner(const char *p, int counts[3], int corner[3])
+{
+    int i;
+    char *end;
+    corner[0] = corner[1] = corner[2] = 0;
+    for(i = 0; i < 3; i++)
     {
-        uv_buffer[o2++] = *vb1;
-        rafgl_list_remove(&uv_coordinates, 0);
+        if(i > 0)
+        {
+            if(*p != '/') break;
+            p++;
+            if(*p == '/') continue;
+        }
+        long value = strtol(p, &end, 10);
+        if(end == p) break;
+        p = end;
+        corner[i] = value < 0 ? counts[i] + (int)value + 1 : (int)value;
     }
+    return p;
+}
 
-    while((vb1 = rafgl_list_get(&normals, 0)) != NULL)
+/* parses the OBJ into deduplicated vertices + indices (malloc'd), fills counts, name and bounds of m. no GL calls */
+static int __obj_parse(rafgl_meshPUN_t *m, const char *obj_path, rafgl_vertexPUN_t **out_vertices, GLuint **out_indices)
+{
+    char *content = rafgl_file_read_content(obj_path);
+    if(content == NULL)
     {
-        normals_buffer[o3++] = *vb1;
-        rafgl_list_remove(&normals, 0);
+        rafgl_log(RAFGL_WARNING, "Can't open OBJ file [%s]\n", obj_path);
+        return -1;
     }
 
-	int fake_uvs = 0;
-	rafgl_list_t vertex_indices, uv_indices, normal_indices;
-    rafgl_list_init(&vertex_indices, sizeof(int));
-    rafgl_list_init(&uv_indices, sizeof(int));
-    rafgl_list_init(&normal_indices, sizeof(int));
+    rafgl_vec_t positions, uvs, normals, corners;
+    rafgl_vec_init(&positions, sizeof(vec3_t));
+    rafgl_vec_init(&uvs, sizeof(vec3_t));
+    rafgl_vec_init(&normals, sizeof(vec3_t));
+    rafgl_vec_init(&corners, 3 * sizeof(int));
 
-    int v1, v2, v3;
-    int n1, n2, n3;
-    int t1, t2, t3;
-
-    while(!feof(f))
-	{
-		while(line[0] != 'f' && !feof(f))
-		{
-			fgets(line, 256, f);
-		}
-
-
-
-		int matches = sscanf(line + 2, "%d/%d/%d %d/%d/%d %d/%d/%d", &v1, &t1, &n1, &v2, &t2, &n2, &v3, &t3, &n3);
-		if(matches != 9)
-		{
-			matches = sscanf(line + 2, "%d//%d %d//%d %d//%d", &v1, &n1, &v2, &n2, &v3, &n3);
-			if(matches != 6)
-			{
-				rafgl_log(RAFGL_WARNING, "File can't be read, try exporting with other options [matches = %d]", matches);
-				rafgl_log(RAFGL_WARNING, "error on: %s\n", line);
-				return;
-			}
-			else
-			{
-				t1 = t2 = t3 = 1;
-				if(!fake_uvs)
-				{
-				    fake_uvs = 1;
-                    rafgl_log(RAFGL_WARNING, "Using fake uvs for model on path [%s]\n", obj_path);
-				}
-			}
-
-
-		}
-
-		rafgl_list_append(&vertex_indices, &v1);
-		rafgl_list_append(&vertex_indices, &v2);
-		rafgl_list_append(&vertex_indices, &v3);
+    vec3_t vectmp;
+    int fake_uvs = 0, fake_normals = 0;
+    int i, k;
 
-		rafgl_list_append(&uv_indices, &t1);
-		rafgl_list_append(&uv_indices, &t2);
-		rafgl_list_append(&uv_indices, &t3);
+    /* single pass over the whole file */
+    const char *p = content;
+    while(*p)
+    {
+        p = __obj_skip_blank(p);
 
-		rafgl_list_append(&normal_indices, &n1);
-		rafgl_list_append(&normal_indices, &n2);
-		rafgl_list_append(&normal_indices, &n3);
-		fgets(line, 256, f);
+        if(p[0] == 'o' && (p[1] == ' ' || p[1] == '\t'))
+        {
+            const char *name = __obj_skip_blank(p + 2);
+            for(k = 0; k < (int)sizeof(m->name) - 1 && !__obj_at_line_end(name + k); k++)
+            {
+                m->name[k] = name[k];
+            }
+            m->name[k] = '\0';
+        }
+        else if(p[0] == 'v' && (p[1] == ' ' || p[1] == '\t'))
+        {
+            __obj_parse_floats(p + 2, &vectmp.x, 3);
+            rafgl_vec_append(&positions, &vectmp);
+        }
+        else if(p[0] == 'v' && p[1] == 't')
+        {
+            __obj_parse_floats(p + 2, &vectmp.x, 2);
+            vectmp.z = 0;
+            rafgl_vec_append(&uvs, &vectmp);
+        }
+        else if(p[0] == 'v' && p[1] == 'n')
+        {
+            __obj_parse_floats(p + 2, &vectmp.x, 3);
+            rafgl_vec_append(&normals, &vectmp);
+        }
+        else if(p[0] == 'f' && (p[1] == ' ' || p[1] == '\t'))
+        {
+            /* polygons are triangulated as a fan around the first corner */
+            int counts[3] = { positions.count, uvs.count, normals.count };
+            int first[3], previous[3], corner[3];
+            int corner_count = 0;
 
+            p += 2;
+            while(1)
+            {
+                p = __obj_skip_blank(p);
+                if(__obj_at_line_end(p)) break;
+
+                const char *start = p;
+                p = __obj_parse_corner(p, counts, corner);
+                if(p == start || corner[0] <= 0 || corner[0] > positions.count)
+                {
+                    rafgl_log(RAFGL_WARNING, "File can't be read, try exporting with other options [%s]\n", obj_path);
+                    corner_count = 0;
+                    break;
+                }
+                while(*p && *p != ' ' && *p != '\t' && !__obj_at_line_end(p)) p++;
+
+                if(corner[1] <= 0 || corner[1] > uvs.count) corner[1] = 0;
+                if(corner[2] <= 0 || corner[2] > normals.count) corner[2] = 0;
+                fake_uvs |= corner[1] == 0;
+                fake_normals |= corner[2] == 0;
+
+                if(corner_count == 0)
+                {
+                    memcpy(first, corner, sizeof(first));
+                }
+                else if(corner_count >= 2)
+                {
+                    rafgl_vec_append(&corners, first);
+                    rafgl_vec_append(&corners, previous);
+                    rafgl_vec_append(&corners, corner);
+                }
+                memcpy(previous, corner, sizeof(previous));
+                corner_count++;
+            }
+        }
 
+        p = __obj_next_line(p);
+    }
 
-	}
+    free(content);
 
-	if(fake_uvs)
+    if(fake_uvs)
+    {
+        rafgl_log(RAFGL_WARNING, "Using fake uvs for model on path [%s]\n", obj_path);
+    }
+    if(fake_normals)
     {
-        vectmp = vec3(0.0f, 0.0f, 0.0f);
-        rafgl_list_append(&uv_coordinates, &vectmp);
+        rafgl_log(RAFGL_WARNING, "Using fake normals for model on path [%s]\n", obj_path);
     }
 
-    rafgl_vertexPUN_t *vertex_buffer = malloc(vertex_indices.count * sizeof(rafgl_vertexPUN_t));
-    int i;
-    int vert_ind;
-    int uv_ind;
-    int norm_ind;
+    int vcount = corners.count;
+    const int *corner_data = corners.data;
+    const vec3_t *position_data = positions.data;
+    const vec3_t *uv_data = uvs.data;
+    const vec3_t *normal_data = normals.data;
 
-    vec3_t vertex_data, uv_data, normal_data;
+    rafgl_vertexPUN_t *vertex_buffer = malloc((vcount + 1) * sizeof(rafgl_vertexPUN_t));
+    GLuint *index_buffer = malloc((vcount + 1) * sizeof(GLuint));
 
-    int vcount = vertex_indices.count;
+    /* dedupe (v, vt, vn) triples, open addressing with linear probing */
+    int table_size = 16;
+    while(table_size < vcount * 2) table_size <<= 1;
+    int table_mask = table_size - 1;
+    int *table_keys = malloc(table_size * 3 * sizeof(int));
+    GLuint *table_values = malloc(table_size * sizeof(GLuint));
+    for(i = 0; i < table_size; i++) table_keys[i * 3] = 0; /* obj indices start at 1, 0 = empty */
+
+    int unique_count = 0;
     for(i = 0; i < vcount; i++)
     {
-        vert_ind = *((int*)rafgl_list_get(&vertex_indices, 0));
-		uv_ind = *((int*)rafgl_list_get(&uv_indices, 0));
-		norm_ind = *((int*)rafgl_list_get(&normal_indices, 0));
+        int vert_ind = corner_data[i * 3];
+        int uv_ind = corner_data[i * 3 + 1];
+        int norm_ind = corner_data[i * 3 + 2];
+
+        unsigned int hash = ((unsigned int)vert_ind * 73856093u) ^ ((unsigned int)uv_ind * 19349663u) ^ ((unsigned int)norm_ind * 83492791u);
+        int slot = hash & table_mask;
+        while(table_keys[slot * 3] != 0 &&
+              (table_keys[slot * 3] != vert_ind || table_keys[slot * 3 + 1] != uv_ind || table_keys[slot * 3 + 2] != norm_ind))
+        {
+            slot = (slot + 1) & table_mask;
+        }
 
-		rafgl_list_remove(&vertex_indices, 0);
-		rafgl_list_remove(&uv_indices, 0);
-		rafgl_list_remove(&normal_indices, 0);
+        if(table_keys[slot * 3] != 0)
+        {
+            index_buffer[i] = table_values[slot];
+            continue;
+        }
 
-		vertex_data = vertices_buffer[vert_ind - 1];
-		uv_data = uv_buffer[uv_ind - 1];
-		normal_data = normals_buffer[norm_ind - 1];
+        table_keys[slot * 3] = vert_ind;
+        table_keys[slot * 3 + 1] = uv_ind;
+        table_keys[slot * 3 + 2] = norm_ind;
+        table_values[slot] = unique_count;
+        index_buffer[i] = unique_count;
+
+        rafgl_vertexPUN_t *vertex = &vertex_buffer[unique_count++];
+        vertex->position = position_data[vert_ind - 1];
+        vertex->normal = norm_ind ? normal_data[norm_ind - 1] : vec3(0.0f, 1.0f, 0.0f);
+        vertex->u = uv_ind ? uv_data[uv_ind - 1].x : 0.0f;
+        vertex->v = 1.0f - (uv_ind ? uv_data[uv_ind - 1].y : 0.0f);
+    }
 
-		vertex_buffer[i].position = vertex_data;
-        vertex_buffer[i].normal = normal_data;
-        vertex_buffer[i].u = uv_data.x;
-        vertex_buffer[i].v = 1.0f - uv_data.y;
+    free(table_keys);
+    free(table_values);
 
+    for(i = 0; i < positions.count; i++)
+    {
+        if(i == 0)
+        {
+            m->bounds_min = m->bounds_max = position_data[0];
+        }
+        vec3_t pos = position_data[i];
+        m->bounds_min = vec3(fminf(m->bounds_min.x, pos.x), fminf(m->bounds_min.y, pos.y), fminf(m->bounds_min.z, pos.z));
+        m->bounds_max = vec3(fmaxf(m->bounds_max.x, pos.x), fmaxf(m->bounds_max.y, pos.y), fmaxf(m->bounds_max.z, pos.z));
+    }
 
+    rafgl_vec_free(&positions);
+    rafgl_vec_free(&uvs);
+    rafgl_vec_free(&normals);
+    rafgl_vec_free(&corners);
 
-    }
+    m -> vertex_count = unique_count;
+    m -> triangle_count = vcount / 3;
+    m -> indexed = 1;
+    m -> index_count = vcount;
 
-    /* GL BUFFER DATA */
+    *out_vertices = vertex_buffer;
+    *out_indices = index_buffer;
+    return 0;
+}
 
+static void __meshPUN_upload(rafgl_meshPUN_t *m, const rafgl_vertexPUN_t *vertices, const GLuint *indices)
+{
 	GLuint vao;
 	glGenVertexArrays(1, &vao);
 
 	m -> vao_id = vao;
-	m -> vertex_count = vcount;
-	m -> triangle_count = vcount / 3;
 
 	glBindVertexArray(vao);
 
 	GLuint data_buffer;
 	glGenBuffers(1, &data_buffer);
 	glBindBuffer(GL_ARRAY_BUFFER, data_buffer);
-	glBufferData(GL_ARRAY_BUFFER, vcount * sizeof(rafgl_vertexPUN_t), vertex_buffer, GL_STATIC_DRAW);
+	glBufferData(GL_ARRAY_BUFFER, m -> vertex_count * sizeof(rafgl_vertexPUN_t), vertices, GL_STATIC_DRAW);
+
+	/* element buffer stays bound to the vao */
+	GLuint element_buffer;
+	glGenBuffers(1, &element_buffer);
+	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, element_buffer);
+	glBufferData(GL_ELEMENT_ARRAY_BUFFER, m -> index_count * sizeof(GLuint), indices, GL_STATIC_DRAW);
 
     glEnableVertexAttribArray(0);
     glEnableVertexAttribArray(1);
@@ -1996,25 +2184,323 @@ void rafgl_meshPUN_load_from_OBJ_offset(rafgl_meshPUN_t *m, const char *obj_path
     glBindBuffer(GL_ARRAY_BUFFER, 0);
     glBindVertexArray(0);
 
+	m->loaded = 1;
+}
 
-    /* free RAM */
-	free(vertex_buffer);
+static void __meshPUN_apply_offset(rafgl_meshPUN_t *m, rafgl_vertexPUN_t *vertices, vec3_t position_offset)
+{
+    unsigned int i;
+    if(position_offset.x == 0.0f && position_offset.y == 0.0f && position_offset.z == 0.0f) return;
 
-	rafgl_list_free(&vertices);
-	rafgl_list_free(&uv_coordinates);
-	rafgl_list_free(&normals);
+    for(i = 0; i < m -> vertex_count; i++)
+    {
+        vertices[i].position = v3_add(vertices[i].position, position_offset);
+    }
+    m -> bounds_min = v3_add(m -> bounds_min, position_offset);
+    m -> bounds_max = v3_add(m -> bounds_max, position_offset);
+}
 
-	rafgl_list_free(&vertex_indices);
-	rafgl_list_free(&uv_indices);
-	rafgl_list_free(&normal_indices);
-	m->loaded = 1;
+/* binary mesh cache */
 
-	free(vertices_buffer);
-	free(uv_buffer);
-	free(normals_buffer);
+static uint64_t __mesh_cache_hash(const void *data, size_t size)
+{
+    /* FNV-1a */
+    const unsigned char *bytes = data;
+    uint64_t hash = 1469598103934665603ULL;
+    size_t i;
+    for(i = 0; i < size; i++)
+    {
+        hash ^= bytes[i];
+        hash *= 1099511628211ULL;
+    }
+    return hash;
+}
 
+static int __mesh_cache_source_info(const char *obj_path, uint64_t *mtime, uint64_t *size)
+{
+    struct stat st;
+    if(stat(obj_path, &st) != 0) return -1;
+    *mtime = (uint64_t)st.st_mtime;
+    *size = (uint64_t)st.st_size;
+    return 0;
+}
+
+static int __mesh_cache_source_hash(const char *obj_path, uint64_t *hash)
+{
+    char *content = rafgl_file_read_content(obj_path);
+    if(content == NULL) return -1;
+    *hash = __mesh_cache_hash(content, strlen(content));
+    free(content);
+    return 0;
+}
+
+/* maps the whole file copy-on-write, writes to the mapping never reach the disk */
+static void* __file_map(const char *path, size_t *size)
+{
+#ifdef _WIN32
+    FILE *f = fopen(path, "rb");
+    if(f == NULL) return NULL;
+    fseek(f, 0, SEEK_END);
+    long length = ftell(f);
+    fseek(f, 0, SEEK_SET);
+    void *data = length > 0 ? malloc(length) : NULL;
+    if(data && fread(data, 1, length, f) != (size_t)length)
+    {
+        free(data);
+        data = NULL;
+    }
+    fclose(f);
+    *size = data ? (size_t)length : 0;
+    return data;
+#else
+    int fd = open(path, O_RDONLY);
+    if(fd < 0) return NULL;
+    struct stat st;
+    if(fstat(fd, &st) != 0 || st.st_size <= 0)
+    {
+        close(fd);
+        return NULL;
+    }
+    void *data = mmap(NULL, st.st_size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if(data == MAP_FAILED) return NULL;
+    *size = (size_t)st.st_size;
+    return data;
+#endif
+}
+
+static void __file_unmap(void *data, size_t size)
+{
+#ifdef _WIN32
+    free(data);
+#else
+    munmap(data, size);
+#endif
+}
+
+static int __mesh_cache_header_valid(const rafgl_mesh_cache_header_t *header, size_t file_size)
+{
+    if(file_size < sizeof(*header)) return 0;
+    if(memcmp(header -> magic, RAFGL_MESH_CACHE_MAGIC, 4) != 0 || header -> version != RAFGL_MESH_CACHE_VERSION) return 0;
+    size_t expected = sizeof(*header) + (size_t)header -> vertex_count * sizeof(rafgl_vertexPUN_t) + (size_t)header -> index_count * sizeof(GLuint);
+    return expected == file_size;
+}
+
+static int __mesh_cache_write(const char *cache_path, const rafgl_meshPUN_t *m, const rafgl_vertexPUN_t *vertices, const GLuint *indices,
+                              uint64_t source_mtime, uint64_t source_size, uint64_t source_hash)
+{
+    rafgl_mesh_cache_header_t header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, RAFGL_MESH_CACHE_MAGIC, 4);
+    header.version = RAFGL_MESH_CACHE_VERSION;
+    header.source_mtime = source_mtime;
+    header.source_size = source_size;
+    header.source_hash = source_hash;
+    header.vertex_count = m -> vertex_count;
+    header.index_count = m -> index_count;
+    header.bounds_min = m -> bounds_min;
+    header.bounds_max = m -> bounds_max;
+    memcpy(header.name, m -> name, sizeof(header.name));
+
+    /* write to a temp file and rename, a crash never leaves a half written cache */
+    char tmp_path[1024];
+    snprintf(tmp_path, sizeof(tmp_path), "%s.tmp", cache_path);
+    FILE *f = fopen(tmp_path, "wb");
+    if(f == NULL) return -1;
+
+    int ok = fwrite(&header, sizeof(header), 1, f) == 1;
+    ok = ok && fwrite(vertices, sizeof(rafgl_vertexPUN_t), m -> vertex_count, f) == m -> vertex_count;
+    ok = ok && fwrite(indices, sizeof(GLuint), m -> index_count, f) == m -> index_count;
+    ok = (fclose(f) == 0) && ok;
+
+    if(!ok || rename(tmp_path, cache_path) != 0)
+    {
+        remove(tmp_path);
+        return -1;
+    }
+    return 0;
+}
+
+int rafgl_meshPUN_build_cache(const char *obj_path, const char *cache_path)
+{
+    uint64_t mtime, size, hash;
+    if(__mesh_cache_source_info(obj_path, &mtime, &size) != 0 || __mesh_cache_source_hash(obj_path, &hash) != 0)
+    {
+        rafgl_log(RAFGL_WARNING, "Can't open OBJ file [%s]\n", obj_path);
+        return -1;
+    }
+
+    rafgl_meshPUN_t m;
+    rafgl_vertexPUN_t *vertices;
+    GLuint *indices;
+    rafgl_meshPUN_init(&m);
+    if(__obj_parse(&m, obj_path, &vertices, &indices) != 0) return -1;
+
+    int result = __mesh_cache_write(cache_path, &m, vertices, indices, mtime, size, hash);
+    if(result != 0)
+    {
+        rafgl_log(RAFGL_WARNING, "Failed to write mesh cache [%s]\n", cache_path);
+    }
+
+    free(vertices);
+    free(indices);
+    return result;
+}
+
+int rafgl_meshPUN_load_from_cache(rafgl_meshPUN_t *m, const char *cache_path, vec3_t position_offset)
+{
+    size_t size;
+    unsigned char *data = __file_map(cache_path, &size);
+    if(data == NULL) return -1;
+
+    rafgl_mesh_cache_header_t *header = (rafgl_mesh_cache_header_t*)data;
+    if(!__mesh_cache_header_valid(header, size))
+    {
+        __file_unmap(data, size);
+        return -1;
+    }
+
+    rafgl_vertexPUN_t *vertices = (rafgl_vertexPUN_t*)(data + sizeof(*header));
+    GLuint *indices = (GLuint*)(vertices + header -> vertex_count);
+
+    memcpy(m -> name, header -> name, sizeof(m -> name));
+    m -> name[sizeof(m -> name) - 1] = '\0';
+    m -> vertex_count = header -> vertex_count;
+    m -> index_count = header -> index_count;
+    m -> triangle_count = header -> index_count / 3;
+    m -> indexed = 1;
+    m -> bounds_min = header -> bounds_min;
+    m -> bounds_max = header -> bounds_max;
+
+    __meshPUN_apply_offset(m, vertices, position_offset);
+    __meshPUN_upload(m, vertices, indices);
+
+    __file_unmap(data, size);
+    return 0;
+}
+
+/* cache is fresh if the OBJ mtime and size match, or its content hash does (e.g. after a fresh checkout) */
+static int __mesh_cache_is_fresh(const char *obj_path, const char *cache_path)
+{
+    uint64_t mtime, size, hash;
+    if(__mesh_cache_source_info(obj_path, &mtime, &size) != 0)
+    {
+        /* only the baked mesh was shipped */
+        return 1;
+    }
+
+    FILE *f = fopen(cache_path, "rb");
+    if(f == NULL) return 0;
+    rafgl_mesh_cache_header_t header;
+    int read_ok = fread(&header, sizeof(header), 1, f) == 1;
     fclose(f);
 
+    if(!read_ok || memcmp(header.magic, RAFGL_MESH_CACHE_MAGIC, 4) != 0 || header.version != RAFGL_MESH_CACHE_VERSION) return 0;
+    if(header.source_size != size) return 0;
+    if(header.source_mtime == mtime) return 1;
+
+    if(__mesh_cache_source_hash(obj_path, &hash) != 0 || hash != header.source_hash) return 0;
+
+    /* same content, remember the new mtime so the next start skips hashing */
+    header.source_mtime = mtime;
+    f = fopen(cache_path, "r+b");
+    if(f != NULL)
+    {
+        fwrite(&header, sizeof(header), 1, f);
+        fclose(f);
+    }
+    return 1;
+}
+
+/* parses the OBJ and refreshes its cache, vertices come back without the offset */
+static int __meshPUN_parse_and_cache(rafgl_meshPUN_t *m, const char *obj_path, const char *cache_path,
+                                     rafgl_vertexPUN_t **out_vertices, GLuint **out_indices)
+{
+    uint64_t mtime = 0, size = 0, hash = 0;
+    int have_source = __mesh_cache_source_info(obj_path, &mtime, &size) == 0 && __mesh_cache_source_hash(obj_path, &hash) == 0;
+
+    if(__obj_parse(m, obj_path, out_vertices, out_indices) != 0) return -1;
+
+    /* cache holds positions without the offset, the same OBJ can be loaded with different offsets */
+    if(have_source && __mesh_cache_write(cache_path, m, *out_vertices, *out_indices, mtime, size, hash) != 0)
+    {
+        rafgl_log(RAFGL_WARNING, "Failed to write mesh cache [%s]\n", cache_path);
+    }
+    return 0;
+}
+
+int rafgl_meshPUN_read_OBJ(rafgl_meshPUN_t *m, const char *obj_path, vec3_t position_offset,
+                           rafgl_vertexPUN_t **out_vertices, GLuint **out_indices)
+{
+    char cache_path[1024];
+    snprintf(cache_path, sizeof(cache_path), "%s%s", obj_path, RAFGL_MESH_CACHE_EXTENSION);
+
+    size_t size;
+    unsigned char *data = __mesh_cache_is_fresh(obj_path, cache_path) ? __file_map(cache_path, &size) : NULL;
+    if(data != NULL)
+    {
+        rafgl_mesh_cache_header_t *header = (rafgl_mesh_cache_header_t*)data;
+        if(__mesh_cache_header_valid(header, size))
+        {
+            /* upload comes later on the GL thread, so the arrays are copied out of the mapping */
+            size_t vertex_bytes = header -> vertex_count * sizeof(rafgl_vertexPUN_t);
+            size_t index_bytes = header -> index_count * sizeof(GLuint);
+            *out_vertices = malloc(vertex_bytes);
+            *out_indices = malloc(index_bytes);
+            memcpy(*out_vertices, data + sizeof(*header), vertex_bytes);
+            memcpy(*out_indices, data + sizeof(*header) + vertex_bytes, index_bytes);
+
+            memcpy(m -> name, header -> name, sizeof(m -> name));
+            m -> name[sizeof(m -> name) - 1] = '\0';
+            m -> vertex_count = header -> vertex_count;
+            m -> index_count = header -> index_count;
+            m -> triangle_count = header -> index_count / 3;
+            m -> indexed = 1;
+            m -> bounds_min = header -> bounds_min;
+            m -> bounds_max = header -> bounds_max;
+            __file_unmap(data, size);
+
+            __meshPUN_apply_offset(m, *out_vertices, position_offset);
+            return 0;
+        }
+        __file_unmap(data, size);
+    }
+
+    if(__meshPUN_parse_and_cache(m, obj_path, cache_path, out_vertices, out_indices) != 0) return -1;
+    __meshPUN_apply_offset(m, *out_vertices, position_offset);
+    return 0;
+}
+
+void rafgl_meshPUN_upload(rafgl_meshPUN_t *m, const rafgl_vertexPUN_t *vertices, const GLuint *indices)
+{
+    __meshPUN_upload(m, vertices, indices);
+}
+
+void rafgl_meshPUN_load_from_OBJ_offset(rafgl_meshPUN_t *m, const char *obj_path, vec3_t position_offset)
+{
+    if(m->loaded)
+    {
+        rafgl_log(RAFGL_WARNING, "Trying to load to already loaded mesh! Loading from [%s] to mesh taken by [%s]", obj_path, m->name);
+        return;
+    }
+
+    char cache_path[1024];
+    snprintf(cache_path, sizeof(cache_path), "%s%s", obj_path, RAFGL_MESH_CACHE_EXTENSION);
+
+    if(__mesh_cache_is_fresh(obj_path, cache_path) && rafgl_meshPUN_load_from_cache(m, cache_path, position_offset) == 0)
+    {
+        return;
+    }
+
+    rafgl_vertexPUN_t *vertices;
+    GLuint *indices;
+    if(__meshPUN_parse_and_cache(m, obj_path, cache_path, &vertices, &indices) != 0) return;
+
+    __meshPUN_apply_offset(m, vertices, position_offset);
+    __meshPUN_upload(m, vertices, indices);
+
+    free(vertices);
+    free(indices);
 }
 
 
@@ -2122,10 +2608,62 @@ int rafgl_list_show(rafgl_list_t *list, void (*fun)(void*, int))
     return 0;
 }
 
+int rafgl_vec_init(rafgl_vec_t *vec, int element_size)
+{
+    vec -> data = NULL;
+    vec -> element_size = element_size;
+    vec -> count = 0;
+    vec -> capacity = 0;
+    return 0;
+}
+
+int rafgl_vec_reserve(rafgl_vec_t *vec, int capacity)
+{
+    if(capacity <= vec -> capacity) return 0;
+
+    void *data = realloc(vec -> data, (size_t)capacity * vec -> element_size);
+    if(data == NULL) return -1;
+
+    vec -> data = data;
+    vec -> capacity = capacity;
+    return 0;
+}
+
+int rafgl_vec_append(rafgl_vec_t *vec, const void *data)
+{
+    if(vec -> count == vec -> capacity)
+    {
+        if(rafgl_vec_reserve(vec, vec -> capacity ? vec -> capacity * 2 : 16)) return -1;
+    }
+    memcpy((char*)vec -> data + (size_t)vec -> count * vec -> element_size, data, vec -> element_size);
+    vec -> count++;
+    return 0;
+}
+
+void* rafgl_vec_get(rafgl_vec_t *vec, int index)
+{
+    if(index < 0 || index >= vec -> count) return NULL;
+    return (char*)vec -> data + (size_t)index * vec -> element_size;
+}
+
+void rafgl_vec_clear(rafgl_vec_t *vec)
+{
+    vec -> count = 0;
+}
+
+void rafgl_vec_free(rafgl_vec_t *vec)
+{
+    free(vec -> data);
+    vec -> data = NULL;
+    vec -> count = 0;
+    vec -> capacity = 0;
+}
+
 int rafgl_file_size(const char *filepath)
 {
     int size = 0;
     FILE *f = fopen(filepath, "rt");
+    if(f == NULL) return -1;
 
     fseek(f, 0L, SEEK_END);
 
@@ -2140,6 +2678,7 @@ char* rafgl_file_read_content(const char *filepath)
 {
     int fsize = rafgl_file_size(filepath);
     FILE *f = fopen(filepath, "rt");
+    if(f == NULL) return NULL;
 
     fseek(f, 0, SEEK_SET);
 
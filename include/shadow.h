@@ -0,0 +1,56 @@
+#ifndef SHADOW_H_INCLUDED
+#define SHADOW_H_INCLUDED
+
+#include <rafgl.h>
+#include <camera.h>
+#include <frustum.h>
+
+// kaskadne senke usmerenog svetla: pogled kamere se deli na kaskade po udaljenosti,
+// svaka ima svoj sloj u depth nizu i ortografsku projekciju oko svog dela frustuma
+#define SHADOW_MAX_CASCADES 4         // isto kao MAX_CASCADES u shaderima i PROFILE_SHADOW*
+#define SHADOW_DEFAULT_CASCADES 3     // TERRAIN_SHADOW_CASCADES=<0..4>, 0 iskljucuje senke
+#define SHADOW_DEFAULT_RESOLUTION 1024 // TERRAIN_SHADOW_RESOLUTION=<px>, po kaskadi
+#define SHADOW_DISTANCE 300.0f        // dalje od kamere nema senki
+#define SHADOW_SPLIT_LAMBDA 0.75f     // 0 ravnomerne podele, 1 logaritamske
+#define SHADOW_CASTER_MARGIN 200.0f   // koliko ispred kaskade (ka svetlu) jos bacaju senku
+#define SHADOW_TEXTURE_UNIT 7         // 0-6 zauzimaju materijali, heightmap, cvorovi i splat
+
+typedef struct {
+    mat4_t view_projection; // za crtanje u sloj
+    mat4_t texture_matrix;  // svet -> [0, 1] koordinate mape i dubina, za shader
+    Frustum frustum;        // culling patchova, chunkova i drveca
+    float split_near, split_far; // duz pogleda kamere
+    float texel_world;      // velicina texela u svetu, za normal offset
+} ShadowCascade;
+
+typedef struct {
+    int cascade_count;
+    int resolution;
+    rafgl_framebuffer_depth_t framebuffer; // jedan sloj po kaskadi
+    ShadowCascade cascades[SHADOW_MAX_CASCADES];
+    GLint saved_framebuffer; // benchmark crta u svoj FBO
+    GLint saved_viewport[4];
+} ShadowMap;
+
+// lokacije u_shadow_* uniforma jednog programa
+typedef struct {
+    GLint map;
+    GLint cascades;
+    GLint matrices;
+    GLint texel;
+} ShadowUniforms;
+
+// cascade_count 0 ne pravi framebuffer
+void shadow_map_init(ShadowMap *shadow, int cascade_count, int resolution);
+// podele i matrice kaskada za ovaj frejm
+void shadow_map_update(ShadowMap *shadow, const Camera *camera, vec3_t light_dir);
+// begin cuva vezan framebuffer i viewport, end ih vraca
+void shadow_map_begin(ShadowMap *shadow);
+void shadow_map_begin_cascade(ShadowMap *shadow, int cascade);
+void shadow_map_end(ShadowMap *shadow);
+void shadow_map_get_uniforms(GLuint program, ShadowUniforms *uniforms);
+// za trenutni program; NULL (ili 0 kaskada) iskljucuje senke u shaderu
+void shadow_map_bind(const ShadowMap *shadow, const ShadowUniforms *uniforms, int texture_unit);
+void shadow_map_cleanup(ShadowMap *shadow);
+
+#endif // SHADOW_H_INCLUDED
@@ -1,8 +1,12 @@
 #ifndef TERRAIN_H_INCLUDED
 #define TERRAIN_H_INCLUDED
 
+#include <stdint.h>
+#include <stddef.h>
 #include <glad/glad.h>
 #include <vertex.h>
+#include <noise.h>
+#include <rafgl.h>
 
 typedef struct {
     float x, y;
@@ -14,36 +18,147 @@ static inline vec2_t vec2_make(float x, float y)
 }
 
 #define PATCH_SIZE 32
-#define LOD_COUNT 3
-static const int g_lod_steps[LOD_COUNT] = {1, 2, 4};
+// log2(PATCH_SIZE) + 1 nivoa, najgrublji je patch od dva trougla
+#define LOD_COUNT 6
+static const int g_lod_steps[LOD_COUNT] = {1, 2, 4, 8, 16, 32};
+#define TERRAIN_LOD_PIXEL_TOLERANCE 2.0f
 #define SKIRT_DEPTH 0.5f
-#define PATCH_SKIRT_VERTICES ((PATCH_SIZE + 1) * 4)
+// ivice izmedju LOD-ova se sivaju indeksima (terrain_patch_edge_mask), pa skirtovi nisu potrebni;
+// -DTERRAIN_SKIRTS=1 ih vraca
+#ifndef TERRAIN_SKIRTS
+#define TERRAIN_SKIRTS 0
+#endif
+#define PATCH_SKIRT_VERTICES (TERRAIN_SKIRTS ? (PATCH_SIZE + 1) * 4 : 0)
+// blok jednog patcha: (PATCH_SIZE+1)^2 grid vertexa red po red, pa skirtovi
+// (gornja, desna, donja, leva ivica)
+#define PATCH_GRID_VERTICES ((PATCH_SIZE + 1) * (PATCH_SIZE + 1))
+#define PATCH_BLOCK_VERTICES (PATCH_GRID_VERTICES + PATCH_SKIRT_VERTICES)
+
+#define TERRAIN_DEFAULT_SIZE (PATCH_SIZE * 40)
+#define TERRAIN_NOISE_SCALE 5.0f
+#define TERRAIN_NOISE_OCTAVES 10 // sto veci broj vise detalja
+
+// indeksi su lokalni za blok (< PATCH_BLOCK_VERTICES) pa staju u 16 bita
+typedef unsigned short TerrainIndex;
+#define TERRAIN_INDEX_GL_TYPE GL_UNSIGNED_SHORT
+
+// bit ivice je postavljen kad je sused na toj ivici jedan LOD grublji,
+// redosled ivica je isti kao kod skirtova
+#define TERRAIN_EDGE_TOP    1
+#define TERRAIN_EDGE_RIGHT  2
+#define TERRAIN_EDGE_BOTTOM 4
+#define TERRAIN_EDGE_LEFT   8
+#define TERRAIN_EDGE_VARIANTS 16
+
+// jedan index buffer sa svim LOD-ovima i varijantama ivica bloka, deli ga svaki patch
+typedef struct {
+    GLuint buffer;
+    int offsets[LOD_COUNT][TERRAIN_EDGE_VARIANTS];  // u indeksima
+    int counts[LOD_COUNT][TERRAIN_EDGE_VARIANTS];
+    int total_count;
+} TerrainLodIndices;
+
+typedef enum {
+    TERRAIN_VERTEX_FULL,    // Vertex, 32 bajta
+    TERRAIN_VERTEX_COMPACT, // TerrainCompactVertex, 4 bajta, x/z/uv se racunaju iz gl_VertexID
+    TERRAIN_VERTEX_HEIGHTMAP // bez vertex buffera, visina i normala iz teksture u vertex shaderu
+} TerrainVertexFormat;
+
+// visina je kvantizovana na [compact_height_min, compact_height_min + compact_height_range],
+// normala je oktaedarski kodirana oko y ose (x i z komponenta u snorm8)
+typedef struct {
+    uint16_t height;
+    int8_t normal[2];
+} TerrainCompactVertex;
 
 typedef struct {
-    GLuint ebo[LOD_COUNT];
-    int index_counts[LOD_COUNT];
     int lod_levels;
-    vec2_t origin; // top-left corner in grid coordinates
+    vec2_t origin;   // top-left corner in grid coordinates
+    int base_vertex; // pocetak bloka ovog patcha u VBO-u
+    float min_height; // sirove vrednosti iz heightmape, bez height_scale
+    float max_height;
+    float lod_error[LOD_COUNT]; // najveca razlika visine LOD-a i punog grida, isto sirova
 } TerrainPatch;
 
 typedef struct {
     int size;              // grid is size x size (e.g., 10x10)
     float *heightmap;      // size*size floats (the raw height data)
-    Vertex *vertices;      // all vertices (grid + skirts)
-    int vertex_count;      // total vertex count uploaded to the VBO
+    TerrainVertexFormat vertex_format; // bira se pre terrain_generate_vertices
+    Vertex *vertices;      // patch blokovi jedan za drugim (grid + skirts), samo u FULL formatu
+    TerrainCompactVertex *compact_vertices; // isti raspored, samo u COMPACT formatu
+    float compact_height_min;   // opseg kvantizacije, deli ga i heightmap tekstura
+    float compact_height_range;
+    int vertex_count;      // total vertex count uploaded to the VBO (u HEIGHTMAP formatu samo raspon gl_VertexID)
     float spacing;         // store spacing for normal calculation and LOD distances
     float height_scale;    // store height_scale for normal calculation
-    TerrainPatch *patches; // patch descriptors (origins + EBOs)
+    TerrainPatch *patches; // patch descriptors (origins + base vertices)
     int patch_cols;
     int patch_rows;
     int patch_count;
     float patch_world_stride;
+    uint32_t seed;         // isti seed daje isti teren
+    NoiseContext noise;
 } Terrain;
 
-void terrain_init(Terrain *terrain, int size);
+// materijal terena: sloj u nizu tekstura + visinski opseg u kome vazi
+#define TERRAIN_MAX_MATERIALS 32 // isto kao MAX_MATERIALS u terrain/frag.glsl
+enum { TERRAIN_SLOPE_ANY = 0, TERRAIN_SLOPE_FLAT = 1, TERRAIN_SLOPE_STEEP = 2 };
+
+typedef struct {
+    const char *path;
+    float band[4]; // ulaz od x do y, izlaz od z do w, po visini normalizovanoj na 0..1
+    int slope;     // TERRAIN_SLOPE_*
+} TerrainMaterial;
+
+// tezine materijala po vertexu grida, 4 materijala po RGBA8 sloju; shader ih cita jednim
+// fetchom umesto da ih racuna po fragmentu
+typedef struct {
+    int size;                 // isto kao terrain->size
+    int layers;               // (material_count + 3) / 4
+    unsigned char *texels;    // layers * size * size * 4, sloj po sloj
+    const TerrainMaterial *materials;
+    int material_count;
+    int dirty_row0, dirty_col0, dirty_row1, dirty_col1; // [0, 1) pravougaonik koji ceka upload, prazan kad je row1 <= row0
+    GLuint texture;           // GL_TEXTURE_2D_ARRAY
+} TerrainSplatMap;
+
+void terrain_init(Terrain *terrain, int size, uint32_t seed);
 void terrain_generate_vertices(Terrain *terrain, float spacing, float height_scale);
+size_t terrain_vertex_stride(TerrainVertexFormat format);
+// podaci za VBO u trenutnom formatu, vertex_count * terrain_vertex_stride bajtova (NULL za HEIGHTMAP)
+const void *terrain_vertex_data(const Terrain *terrain);
+// R16 tekstura size x size sa visinama kvantizovanim na compact_height_min/range
+GLuint terrain_heightmap_texture_create(const Terrain *terrain);
 void terrain_calculate_normals(Terrain *terrain);
-unsigned int *terrain_build_patch_indices(const Terrain *terrain, const TerrainPatch *patch, int lod_step, int *out_index_count);
+
+// peceni splat: posle terrain_generate_vertices (treba spacing i height_scale), CPU deo na svim jezgrima
+void terrain_splat_init(TerrainSplatMap *splat, const Terrain *terrain, const TerrainMaterial *materials, int material_count);
+// heightmap se promenila u [row0, row1) x [col0, col1): ponovo se pece samo taj deo (sa ivicom od
+// jednog vertexa zbog normala) i oznacava za upload
+void terrain_splat_update_region(TerrainSplatMap *splat, const Terrain *terrain, int row0, int col0, int row1, int col1);
+// GL nit: pravi teksturu pri prvom pozivu, kasnije salje samo prljavi pravougaonik
+void terrain_splat_upload(TerrainSplatMap *splat);
+void terrain_splat_destroy(TerrainSplatMap *splat);
+// vertex iz visinske mape (pozicija + normala), ne zavisi od vertex buffera
+Vertex terrain_grid_vertex(const Terrain *terrain, int row, int col);
+
+// AABB patcha u svetu (ukljucuje skirtove), za frustum culling
+void terrain_patch_bounds(const Terrain *terrain, const TerrainPatch *patch, vec3_t *out_min, vec3_t *out_max);
+
+// lod po udaljenosti od centra patcha (streaming chunkovi nemaju lod_error)
+int terrain_lod_for_distance(float distance);
+// najgrublji lod cija greska na ekranu nije veca od pixel_tolerance piksela;
+// lod_scale = visina viewporta / (2 * tan(fov / 2)). Susedi se razlikuju najvise za jedan.
+void terrain_select_lods(const Terrain *terrain, vec3_t camera_pos, float lod_scale, float pixel_tolerance, int *out_lods);
+// TERRAIN_EDGE_* maska ivica ciji je sused grublji
+int terrain_patch_edge_mask(const Terrain *terrain, const int *lods, int patch_index);
+// indeksi za blok od PATCH_BLOCK_VERTICES, isti za svaki blok pa se mogu deliti;
+// ivice iz edge_mask se spajaju sa susedom koji ima dvostruko veci korak
+TerrainIndex *terrain_build_block_indices(int lod_step, int edge_mask, int *out_index_count);
+void terrain_lod_indices_create(TerrainLodIndices *lod_indices);
+void terrain_lod_indices_destroy(TerrainLodIndices *lod_indices);
+// popunjava skirt deo bloka iz vec izracunatih grid vertexa
+void terrain_block_build_skirts(Vertex *block);
 
 #endif // TERRAIN_H_INCLUDED
 
@@ -0,0 +1,64 @@
+#ifndef TERRAIN_DRAW_H_INCLUDED
+#define TERRAIN_DRAW_H_INCLUDED
+
+#include <glad/glad.h>
+
+// glad je generisan za 3.3, indirect crtanje (4.3 / ARB_multi_draw_indirect) se ucitava rucno
+#ifndef GL_DRAW_INDIRECT_BUFFER
+#define GL_DRAW_INDIRECT_BUFFER 0x8F3F
+#endif
+
+// raspored koji ocekuje glMultiDrawElementsIndirect
+typedef struct {
+    GLuint count;
+    GLuint instance_count;
+    GLuint first_index;
+    GLint base_vertex;
+    GLuint base_instance;
+} TerrainDrawCommand;
+
+typedef enum {
+    TERRAIN_DRAW_INDIRECT,   // glMultiDrawElementsIndirect iz GL_DRAW_INDIRECT_BUFFER
+    TERRAIN_DRAW_BASE_VERTEX // glMultiDrawElementsBaseVertex, GL 3.2
+} TerrainDrawPath;
+
+typedef struct {
+    float key;
+    int index;
+} TerrainDrawSortItem;
+
+// komande svih vidljivih patchova jednog frejma, salju se jednim pozivom
+typedef struct {
+    TerrainDrawPath path;
+    TerrainDrawCommand *commands;
+    float *sort_keys;               // kvadrat udaljenosti od kamere, za terrain_draw_list_sort
+    TerrainDrawSortItem *sort_items;
+    TerrainDrawCommand *sorted;     // zamenjuje se sa commands posle sortiranja
+    // isto za fallback putanju
+    GLsizei *counts;
+    const void **offsets;
+    GLint *base_vertices;
+    int count;
+    int capacity;
+    GLuint indirect_buffer;
+} TerrainDrawList;
+
+// odakle se ucitava glMultiDrawElementsIndirect, podrazumevano glfwGetProcAddress (benchmark ga menja za EGL)
+void terrain_draw_set_proc_loader(GLADloadproc loader);
+// TERRAIN_NO_INDIRECT forsira fallback; VAO se ne menja
+void terrain_draw_list_init(TerrainDrawList *list, int capacity);
+static inline void terrain_draw_list_reset(TerrainDrawList *list)
+{
+    list->count = 0;
+}
+// first_index je u indeksima (kao TerrainLodIndices offsets), sort_key je kvadrat udaljenosti od kamere
+void terrain_draw_list_add(TerrainDrawList *list, int index_count, int first_index, int base_vertex, float sort_key);
+// napred ka nazad: blizi patchovi prvi popune depth, dalji fragmenti padaju na early-z
+void terrain_draw_list_sort(TerrainDrawList *list);
+// crta sve komande iz trenutno vezanog VAO-a, vraca broj GL draw poziva
+int terrain_draw_list_submit(TerrainDrawList *list, GLenum index_type, size_t index_size);
+// ponovo crta vec poslate komande (npr. posle depth pre-passa), bez novog uploada
+int terrain_draw_list_redraw(TerrainDrawList *list, GLenum index_type);
+void terrain_draw_list_destroy(TerrainDrawList *list);
+
+#endif // TERRAIN_DRAW_H_INCLUDED
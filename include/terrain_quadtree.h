@@ -0,0 +1,54 @@
+#ifndef TERRAIN_QUADTREE_H_INCLUDED
+#define TERRAIN_QUADTREE_H_INCLUDED
+
+#include <glad/glad.h>
+#include <rafgl.h>
+#include <terrain.h>
+#include <frustum.h>
+
+// CDLOD: cvor nivoa L pokriva PATCH_SIZE << L celija i crta se istim gridom
+// od PATCH_SIZE x PATCH_SIZE kvadova (korak 1 << L), pa broj crtanja zavisi
+// od pogleda a ne od velicine sveta
+#define TERRAIN_QUADTREE_MAX_LEVELS 16
+#define TERRAIN_QUADTREE_MAX_DRAWS 4096
+#define TERRAIN_QUADTREE_MORPH_START 0.66f // deo opsega posle kog pocinje morph ka grubljem nivou
+#define TERRAIN_QUADTREE_SHADER_MODE 3      // u_vertex_format u terrain/vert.glsl
+
+typedef struct {
+    int col, row;                 // gornji levi ugao u celijama grida
+    int level;                    // 0 = jedan TerrainPatch
+    float min_height, max_height; // sirove, kao u TerrainPatch
+    int children[4];              // -1 ako je dete van grida
+} TerrainQuadNode;
+
+// jedno crtanje, isti raspored kao texel u u_nodes (RGBA32F)
+typedef struct {
+    float col, row;   // pocetak oblasti u celijama
+    float cell_size;  // 1 << nivo cvora; grid od PATCH_SIZE celija te velicine
+    float level;      // nivo kojim se crta (korak kvada 1 << level), odredjuje morph
+} TerrainQuadDraw;
+
+typedef struct {
+    TerrainQuadNode *nodes;
+    int node_count;
+    int root;
+    int levels;
+    float ranges[TERRAIN_QUADTREE_MAX_LEVELS];      // udaljenost do koje nivo vazi
+    float morph_ranges[TERRAIN_QUADTREE_MAX_LEVELS][2]; // pocetak/kraj morpha po nivou
+
+    TerrainQuadDraw draws[TERRAIN_QUADTREE_MAX_DRAWS];
+    int draw_count;
+    GLuint draw_buffer;   // texture buffer sa draws, shader ga cita preko gl_VertexID
+    GLuint draw_texture;
+    CullCounter cull;     // izabrani / odbaceni cvorovi
+} TerrainQuadtree;
+
+// leaf_range je udaljenost do koje se crta puna rezolucija, svaki sledeci nivo duplo dalje
+void terrain_quadtree_build(TerrainQuadtree *tree, const Terrain *terrain, float leaf_range);
+// bira cvorove za ovaj frejm i salje ih u draw_buffer
+void terrain_quadtree_select(TerrainQuadtree *tree, const Terrain *terrain, vec3_t camera_pos, const Frustum *frustum);
+// indeks LOD-a iz TerrainLodIndices za crtanje (0 za ceo cvor, 1 za cetvrtinu roditelja)
+int terrain_quadtree_draw_lod(const TerrainQuadDraw *draw);
+void terrain_quadtree_destroy(TerrainQuadtree *tree);
+
+#endif // TERRAIN_QUADTREE_H_INCLUDED
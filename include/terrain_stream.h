@@ -0,0 +1,71 @@
+#ifndef TERRAIN_STREAM_H_INCLUDED
+#define TERRAIN_STREAM_H_INCLUDED
+
+#include <stdint.h>
+#include <pthread.h>
+#include <rafgl.h>
+#include <terrain.h>
+#include <frustum.h>
+#include <thread_pool.h>
+
+// beskonacan svet od chunkova velicine jednog TerrainPatch-a
+#define STREAM_VIEW_RADIUS 8                          // u chunkovima oko kamere
+#define STREAM_EVICT_RADIUS (STREAM_VIEW_RADIUS + 2)  // dalje od ovoga se izbacuje
+#define STREAM_WINDOW (2 * STREAM_EVICT_RADIUS + 1)
+#define STREAM_SLOT_COUNT (STREAM_WINDOW * STREAM_WINDOW)
+#define STREAM_MAX_IN_FLIGHT 32
+#define STREAM_UPLOAD_BUDGET_BYTES (512 * 1024)       // po frejmu
+
+typedef enum {
+    CHUNK_EMPTY = 0,
+    CHUNK_GENERATING,  // worker nit pravi vertexe
+    CHUNK_READY,       // vertexi gotovi, ceka upload na glavnoj niti
+    CHUNK_RESIDENT     // na GPU-u
+} TerrainChunkState;
+
+struct TerrainStream;
+
+typedef struct {
+    struct TerrainStream *stream;
+    int cx, cz;              // koordinate chunka u svetu
+    TerrainChunkState state;
+    Vertex *vertices;        // PATCH_BLOCK_VERTICES, postoji samo do uploada
+    float min_height;
+    float max_height;
+    GLuint vao;              // vao/vbo pripadaju slotu i ponovo se koriste
+    GLuint vbo;
+} TerrainChunk;
+
+typedef struct TerrainStream {
+    // chunk (cx, cz) uvek zauzima slot (cx mod W, cz mod W), pa je memorija
+    // ogranicena brojem slotova bez obzira koliko daleko kamera ode
+    TerrainChunk slots[STREAM_SLOT_COUNT];
+    NoiseContext noise;
+    float spacing;
+    float height_scale;
+    float noise_step;        // pomeraj u sumu po celiji grida
+    int octaves;
+
+    TerrainLodIndices lod_indices; // svi LOD-ovi jednog bloka, deli ga svaki chunk
+
+    ThreadPool *pool;
+    ThreadPoolGroup jobs;
+    pthread_mutex_t mutex;
+    int in_flight;
+    int upload_budget_bytes;
+
+    int center_cx, center_cz;
+    int resident_count;
+    int uploads_last_frame;
+    CullCounter cull;        // chunkovi u prozoru u poslednjem frejmu
+    int triangles;           // nacrtani u poslednjem frejmu
+} TerrainStream;
+
+void terrain_stream_init(TerrainStream *stream, uint32_t seed, float spacing, float height_scale);
+// izbacuje daleke chunkove, trazi nove i uploaduje gotove u okviru budzeta
+void terrain_stream_update(TerrainStream *stream, vec3_t camera_pos);
+// crta rezidentne chunkove trenutno bindovanim terrain shaderom
+void terrain_stream_render(TerrainStream *stream, vec3_t camera_pos, const Frustum *frustum);
+void terrain_stream_cleanup(TerrainStream *stream);
+
+#endif // TERRAIN_STREAM_H_INCLUDED
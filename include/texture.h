@@ -2,8 +2,29 @@
 #define TEXTURE_H_INCLUDED
 
 #include <glad/glad.h>
+#include <texture_bc.h>
 
+// GL format za stbi sliku sa 1-4 kanala (GL_RED, GL_RG, GL_RGB, GL_RGBA)
+GLenum texture_pixel_format(int channels);
+int texture_mip_level_count(int width, int height);
+
+// izbor formata, isti za sinhrone loadere i texture_stream: BC samo ako su sve strane/slojevi
+// iz .rtex-a istog formata, velicine i broja nivoa, inace se sve dekodira iz PNG-ova
+int texture_bc_faces_usable(const TextureBcImage *faces, int count);
+// dekodirane strane/slojevi moraju biti iste velicine i broja kanala
+int texture_faces_match(const int *widths, const int *heights, const int *channels, int count);
+
+// zajednicko za sinhrone loadere i texture_stream: prazan storage za sve nivoe i strane cubemapa
+// (ili slojeve niza) sa filterima, tekstura ostaje vezana; bc_format 0 za nekompresovane
+GLuint texture_storage_create(GLenum target, uint32_t bc_format, int channels, int width, int height, int faces, int level_count);
+// redovi [y, y + height) jednog nivoa strane/sloja u vezanu teksturu; data moze biti offset u PBO
+void texture_upload_rows(GLenum target, int face, int level, int y, int width, int height,
+                         uint32_t bc_format, int channels, GLsizei bytes, const void *data);
+
+// sinhroni loaderi; .rtex samo ako je pecen za sve strane/slojeve i drajver ima S3TC, inace sve iz PNG-ova
 GLuint texture_load(const char *filepath);
 GLuint texture_load_cubemap(const char **faces, int count);
+// GL_TEXTURE_2D_ARRAY, svi slojevi iste velicine i formata; jedan bind za sve materijale
+GLuint texture_load_array(const char **paths, int count);
 
 #endif // TEXTURE_H_INCLUDED
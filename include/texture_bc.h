@@ -0,0 +1,61 @@
+#ifndef TEXTURE_BC_H_INCLUDED
+#define TEXTURE_BC_H_INCLUDED
+
+#include <stddef.h>
+#include <stdint.h>
+#include <glad/glad.h>
+
+// blok-kompresovana tekstura sa gotovim mipovima, pravi je tools/texconv.c (make textures)
+// fajl: zaglavlje, pa nivoi redom od najveceg, svaki level_sizes[i] bajtova 4x4 blokova
+#define TEXTURE_BC_MAGIC "RTEX"
+#define TEXTURE_BC_VERSION 1
+#define TEXTURE_BC_EXTENSION ".rtex"
+#define TEXTURE_BC_MAX_LEVELS 16
+
+// S3TC nije u core profilu pa ga glad za 3.3 ne definise
+#ifndef GL_COMPRESSED_RGB_S3TC_DXT1_EXT
+#define GL_COMPRESSED_RGB_S3TC_DXT1_EXT 0x83F0
+#endif
+#ifndef GL_COMPRESSED_RGBA_S3TC_DXT5_EXT
+#define GL_COMPRESSED_RGBA_S3TC_DXT5_EXT 0x83F3
+#endif
+
+typedef enum {
+    TEXTURE_BC_AUTO = 0, // BC3 ako alfa nije svuda 255, BC5 za dvokanalne slike, inace BC1
+    TEXTURE_BC1 = 1,     // RGB, 8 bajtova po bloku
+    TEXTURE_BC3 = 3,     // RGBA, 16 bajtova po bloku
+    TEXTURE_BC5 = 5      // RG (npr. xy normal mape), 16 bajtova po bloku
+} TextureBcFormat;
+
+typedef struct {
+    char magic[4];
+    uint32_t version;
+    uint32_t format;
+    uint32_t width, height;
+    uint32_t level_count;
+    uint64_t source_mtime; // PNG iz kog je napravljen, kao kod .rmesh kesa
+    uint64_t source_size;
+    uint32_t level_sizes[TEXTURE_BC_MAX_LEVELS];
+} TextureBcHeader;
+
+typedef struct {
+    TextureBcHeader header;
+    unsigned char *data;                          // svi nivoi u jednom bloku
+    unsigned char *levels[TEXTURE_BC_MAX_LEVELS]; // pokazuju u data
+} TextureBcImage;
+
+// kompresuje PNG sa box filter mipovima; vraca 0 ako je fajl upisan
+int texture_bc_bake(const char *png_path, const char *output_path, TextureBcFormat format);
+
+// cita <png_path>.rtex ako postoji i nije stariji od PNG-a; bez GL poziva, moze na worker niti
+int texture_bc_read(TextureBcImage *image, const char *png_path);
+void texture_bc_free(TextureBcImage *image);
+
+GLenum texture_bc_gl_format(uint32_t format);
+int texture_bc_block_bytes(uint32_t format);
+size_t texture_bc_level_size(uint32_t format, int width, int height);
+
+// GL nit; 0 ako drajver nema S3TC ili je TERRAIN_NO_BC=1
+int texture_bc_supported(void);
+
+#endif // TEXTURE_BC_H_INCLUDED
@@ -0,0 +1,87 @@
+#ifndef TEXTURE_STREAM_H_INCLUDED
+#define TEXTURE_STREAM_H_INCLUDED
+
+#include <pthread.h>
+#include <glad/glad.h>
+#include <thread_pool.h>
+#include <texture_bc.h>
+
+// asinhrono ucitavanje tekstura: dekodiranje i mipovi (ili citanje .rtex) na worker nitima,
+// upload na glavnoj niti kroz PBO u trakama redova, uz budzet bajtova po frejmu
+#define TEXTURE_STREAM_MAX_TEXTURES 32
+#define TEXTURE_STREAM_MAX_LEVELS TEXTURE_BC_MAX_LEVELS // isto kao granica texture_mip_level_count
+#define TEXTURE_STREAM_MAX_LAYERS 32 // strane cubemapa ili slojevi niza tekstura
+#define TEXTURE_STREAM_PATH_LENGTH 256
+#define TEXTURE_STREAM_UPLOAD_BUDGET_BYTES (2 * 1024 * 1024) // po frejmu
+
+typedef enum {
+    TEXTURE_STREAM_DECODING = 0, // worker niti dekodiraju strane i prave mipove
+    TEXTURE_STREAM_UPLOADING,    // sve strane gotove, upload traje vise frejmova
+    TEXTURE_STREAM_RESIDENT,
+    TEXTURE_STREAM_FAILED        // ostaje placeholder
+} TextureStreamState;
+
+struct TextureStream;
+
+typedef struct {
+    struct TextureStream *stream;
+    int entry;
+    int face;
+} TextureStreamJob;
+
+typedef struct {
+    char paths[TEXTURE_STREAM_MAX_LAYERS][TEXTURE_STREAM_PATH_LENGTH];
+    int face_count;          // 1 za 2D teksturu, 6 za cubemap, broj slojeva za niz
+    GLenum target;
+    TextureStreamState state;
+    int faces_decoded;       // pod mutexom, pisu ga worker niti
+    int failed;
+    TextureStreamJob jobs[TEXTURE_STREAM_MAX_LAYERS];
+
+    // nivo 0 je slika iz stbi_load, ostali su box filter prethodnog
+    unsigned char *levels[TEXTURE_STREAM_MAX_LAYERS][TEXTURE_STREAM_MAX_LEVELS];
+    int widths[TEXTURE_STREAM_MAX_LAYERS];
+    int heights[TEXTURE_STREAM_MAX_LAYERS];
+    int channels[TEXTURE_STREAM_MAX_LAYERS];
+    int level_count;
+    // <png>.rtex: nivoi pokazuju u blokove iz fajla, mipovi se ne racunaju
+    TextureBcImage compressed[TEXTURE_STREAM_MAX_LAYERS];
+    GLenum compressed_format;    // 0 za nekompresovane, postavlja se pred upload
+    int png_only;                // strane su imale razlicite formate, sve se ponovo dekodiraju iz PNG-a
+
+    // sledeca traka za upload
+    int upload_face, upload_level, upload_row;
+    GLuint texture;          // vidljiva tek kad je RESIDENT
+} TextureStreamEntry;
+
+typedef struct TextureStream {
+    TextureStreamEntry entries[TEXTURE_STREAM_MAX_TEXTURES];
+    int count;
+    int pending;             // jos nisu RESIDENT ni FAILED
+
+    GLuint placeholder_2d;   // 1x1, bindovan dok prava tekstura ne stigne
+    GLuint placeholder_cube;
+    GLuint placeholder_array; // jedan sloj, shader ga dobija za svaki indeks sloja
+    GLuint pbo;              // orphan pre svake trake, drajver ne ceka prethodni upload
+
+    ThreadPool *pool;
+    ThreadPoolGroup jobs;
+    pthread_mutex_t mutex;
+    int upload_budget_bytes;
+    int use_compressed;      // drajver ima S3TC, worker niti traze .rtex pre PNG-a
+    int uploaded_last_frame; // bajtova
+} TextureStream;
+
+void texture_stream_init(TextureStream *stream);
+// vracaju id za texture_stream_get, ili -1 ako nema mesta
+int texture_stream_request(TextureStream *stream, const char *path);
+int texture_stream_request_cubemap(TextureStream *stream, const char **faces);
+// GL_TEXTURE_2D_ARRAY, svi slojevi moraju biti iste velicine i formata
+int texture_stream_request_array(TextureStream *stream, const char **paths, int count);
+// uploaduje gotove trake u okviru budzeta, jednom po frejmu na GL niti
+void texture_stream_update(TextureStream *stream);
+// prava tekstura kad je ucitana, do tada placeholder
+GLuint texture_stream_get(const TextureStream *stream, int id);
+void texture_stream_cleanup(TextureStream *stream);
+
+#endif // TEXTURE_STREAM_H_INCLUDED
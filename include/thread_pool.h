@@ -0,0 +1,48 @@
+#ifndef THREAD_POOL_H_INCLUDED
+#define THREAD_POOL_H_INCLUDED
+
+#include <pthread.h>
+
+typedef void (*ThreadPoolJobFn)(void *user);
+typedef void (*ThreadPoolRangeFn)(void *user, int begin, int end);
+
+typedef struct ThreadPoolJob {
+    ThreadPoolJobFn fn;
+    void *user;
+    struct ThreadPoolGroup *group;
+    struct ThreadPoolJob *next;
+} ThreadPoolJob;
+
+// grupa poslova na koju se moze cekati (npr. sve trake jednog parallel_for)
+typedef struct ThreadPoolGroup {
+    int pending;
+} ThreadPoolGroup;
+
+typedef struct {
+    pthread_t *threads;
+    int thread_count;      // broj worker niti, 0 znaci da se sve radi na pozivaocu
+    pthread_mutex_t mutex;
+    pthread_cond_t work_cond;
+    pthread_cond_t done_cond;
+    ThreadPoolJob *head;
+    ThreadPoolJob *tail;
+    int shutting_down;
+} ThreadPool;
+
+// thread_count < 0 bira broj jezgara - 1 (pozivalac je takodje radnik)
+void thread_pool_init(ThreadPool *pool, int thread_count);
+void thread_pool_cleanup(ThreadPool *pool);
+
+void thread_pool_submit(ThreadPool *pool, ThreadPoolGroup *group, ThreadPoolJobFn fn, void *user);
+// dok ceka, pozivalac izvrsava poslove iz reda pa ugnjezdeni pozivi ne blokiraju
+void thread_pool_wait(ThreadPool *pool, ThreadPoolGroup *group);
+
+// deli [0, count) na trake i ceka da se sve zavrse
+// fn mora da pise samo u svoj opseg, rezultat tada ne zavisi od broja niti
+void thread_pool_parallel_for(ThreadPool *pool, int count, ThreadPoolRangeFn fn, void *user);
+
+// deljeni pool, broj niti se moze ograniciti sa TERRAIN_THREADS=<n> (1 = bez worker niti)
+ThreadPool *thread_pool_shared(void);
+void thread_pool_shared_shutdown(void);
+
+#endif // THREAD_POOL_H_INCLUDED
@@ -3,7 +3,13 @@
 
 #include <rafgl.h>
 #include <terrain.h>
+#include <frustum.h>
+#include <shadow.h>
 
+// gornja granica broja drveca, prava vrednost zavisi i od broja pogodnih vertexa
+#define TREE_MAX_INSTANCES 30000
+
+// tacno ovaj raspored ide u instance VBO (27 floatova po drvetu)
 typedef struct {
     mat4_t model;
     float normal_matrix[9];
@@ -11,27 +17,59 @@ typedef struct {
     float leaf_transition_height;
 } TreeInstance;
 
+// svaki pass pamti svoj vidljivi skup, pa kaskade senki ne ponistavaju kes kamere
+#define TREE_VIEW_CAMERA 0                       // depth pre-pass i glavni pass
+#define TREE_VIEW_SHADOW(cascade) (1 + (cascade))
+#define TREE_VIEW_COUNT (1 + SHADOW_MAX_CASCADES)
+
+typedef struct {
+    GLuint instance_vbo;         // vidljive instance ovog pogleda
+    int visible_count;
+    mat4_t last_view_projection; // ista matrica -> isti vidljivi skup, nema uploada
+    int valid;
+} TreeView;
+
+// sfera oko cele krosnje, za frustum culling
+typedef struct {
+    vec3_t center;
+    float radius;
+} TreeBounds;
+
 typedef struct {
     rafgl_meshPUN_t mesh;
+    rafgl_vertexPUN_t *mesh_vertices; // procitan mesh koji ceka upload
+    GLuint *mesh_indices;
     GLuint program;
-    GLint u_mvp_loc;
-    GLint u_model_loc;
-    GLint u_normal_loc;
+    GLint u_view_projection_loc;
     GLint u_light_dir_loc;
     GLint u_light_color_loc;
     GLint u_ambient_color_loc;
     GLint u_trunk_color_loc;
     GLint u_leaf_color_loc;
-    GLint u_leaf_start_loc;
-    GLint u_leaf_transition_loc;
+    GLint u_depth_only_loc;
+    GLint u_overdraw_loc;
+    ShadowUniforms shadow_uniforms;
     TreeInstance *instances;
+    TreeBounds *bounds;
+    TreeInstance *visible;    // scratch za culling, odavde se uploaduje u VBO pogleda
     int instance_count;
+    TreeView views[TREE_VIEW_COUNT];
+    int bound_view;           // ciji VBO je trenutno u atributima VAO-a, -1 nijedan
     vec3_t trunk_color;
     vec3_t leaf_color;
+    int depth_only;           // 1: pre-pass i shadow pass, fragment shader ne racuna boju
+    int overdraw;             // 1: svaki fragment dodaje istu boju, za merenje overdrawa
+    const ShadowMap *shadow;  // NULL u samom shadow passu i kad su senke iskljucene
+    CullCounter cull;
 } TreeSystem;
 
-void tree_system_init(TreeSystem *system, const Terrain *terrain);
-void tree_system_render(TreeSystem *system, mat4_t view_projection, vec3_t light_dir, vec3_t light_color, vec3_t ambient_color);
+void tree_system_init(TreeSystem *system, const Terrain *terrain, uint32_t seed);
+// init u tri koraka: prva dva su samo CPU (mogu na worker niti), upload mora na GL niti
+void tree_system_load_mesh(TreeSystem *system);
+void tree_system_place(TreeSystem *system, const Terrain *terrain, uint32_t seed);
+void tree_system_upload(TreeSystem *system);
+// view je TREE_VIEW_CAMERA ili TREE_VIEW_SHADOW(i)
+void tree_system_render(TreeSystem *system, int view, mat4_t view_projection, const Frustum *frustum, vec3_t light_dir, vec3_t light_color, vec3_t ambient_color);
 void tree_system_cleanup(TreeSystem *system);
 
 #endif // TREE_H_INCLUDED
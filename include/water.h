@@ -2,6 +2,7 @@
 #define WATER_H_INCLUDED
 
 #include <rafgl.h>
+#include <frustum.h>
 
 typedef struct
 {
@@ -21,10 +22,13 @@ typedef struct
     float reflection_strength;
     float height;
     float extent;
+    CullCounter cull;
 } Water;
 
 void water_init(Water *water, float extent, float height);
-void water_render(Water *water, mat4_t view_projection, GLuint skybox_texture, vec3_t camera_pos);
+// voda prati kameru u beskonacnom svetu
+void water_set_center(Water *water, float x, float z);
+void water_render(Water *water, mat4_t view_projection, const Frustum *frustum, GLuint skybox_texture, vec3_t camera_pos);
 void water_cleanup(Water *water);
 
 #endif // WATER_H_INCLUDED
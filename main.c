@@ -10,9 +10,15 @@
 
 #include <game_constants.h>
 #include <main_state.h>
+#include <benchmark.h>
 
 int main(int argc, char *argv[])
 {
+    BenchmarkConfig benchmark;
+    if (benchmark_parse_args(argc, argv, &benchmark))
+    {
+        return benchmark_run(&benchmark);
+    }
 
     rafgl_game_t game;
 
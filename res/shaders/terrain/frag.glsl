@@ -5,55 +5,148 @@ out vec4 frag_color;
 in vec2 v_texcoord;
 in float v_height;
 in vec3 v_normal;
+in vec3 v_world_pos;
 
-// teksture
-uniform sampler2D u_tex_sand;
-uniform sampler2D u_tex_grass;
-uniform sampler2D u_tex_rock;
-uniform sampler2D u_tex_snow;
+// materijali: slojevi jednog niza tekstura, opisi u terrain_materials (main_state.c)
+#define MAX_MATERIALS 32
+const int SLOPE_ANY = 0;   // nagib ne utice
+const int SLOPE_FLAT = 1;  // bledi na strmim padinama
+const int SLOPE_STEEP = 2; // preuzima strme padine
+
+uniform sampler2DArray u_materials;
+uniform int u_material_count;
+uniform vec4 u_material_bands[MAX_MATERIALS]; // ulaz x..y, izlaz z..w po normalizovanoj visini
+uniform int u_material_slope[MAX_MATERIALS];
+
+// fiksni teren: tezine su vec pecene u vertexima grida (terrain_splat_init), 4 po sloju
+uniform int u_use_splat;        // 0 za streaming chunkove, oni nemaju splat mapu
+uniform sampler2DArray u_splat;
+uniform int u_splat_layers;
+
+// depth pre-pass ne pise boju, pa shader nema sta da racuna
+uniform int u_depth_only;
+// overdraw mod: svaki fragment koji prodje depth test dodaje istu boju (aditivni blend),
+// pa svetlina piksela pokazuje koliko puta je sencen
+uniform int u_overdraw;
+const vec4 OVERDRAW_COLOR = vec4(0.2, 0.1, 0.04, 1.0);
 
 // svetlost
 uniform vec3 u_light_dir;      
 uniform vec3 u_light_color;   
 uniform vec3 u_ambient_color;  
 
+// kaskadne senke (shadow.c), u_shadow_cascades je 0 kad su iskljucene
+#define MAX_CASCADES 4
+uniform sampler2DArrayShadow u_shadow_map;
+uniform int u_shadow_cascades;
+uniform mat4 u_shadow_matrices[MAX_CASCADES]; // svet -> [0, 1]
+uniform float u_shadow_texel[MAX_CASCADES];   // velicina texela u svetu
+
+// 1 osvetljeno, 0 u senci; prva kaskada koja sadrzi tacku je i najostrija
+float shadow_factor(vec3 world_pos, vec3 N)
+{
+    for (int i = 0; i < u_shadow_cascades; ++i)
+    {
+        // pomeraj duz normale raste sa texelom kaskade, skida akne na strmim padinama
+        vec3 p = (u_shadow_matrices[i] * vec4(world_pos + N * (1.5 * u_shadow_texel[i]), 1.0)).xyz;
+        if (all(greaterThan(p, vec3(0.0))) && all(lessThan(p, vec3(1.0))))
+        {
+            // 4 bilinearna poredjenja = PCF 3x3 texela
+            vec2 texel = 1.0 / vec2(textureSize(u_shadow_map, 0).xy);
+            float lit = texture(u_shadow_map, vec4(p.xy + vec2(-0.5, -0.5) * texel, float(i), p.z))
+                      + texture(u_shadow_map, vec4(p.xy + vec2( 0.5, -0.5) * texel, float(i), p.z))
+                      + texture(u_shadow_map, vec4(p.xy + vec2(-0.5,  0.5) * texel, float(i), p.z))
+                      + texture(u_shadow_map, vec4(p.xy + vec2( 0.5,  0.5) * texel, float(i), p.z));
+            return lit * 0.25;
+        }
+    }
+    return 1.0;
+}
+
+// isto kao splat_rows u terrain.c
+float material_weight(int i, float h, float slope_bias)
+{
+    vec4 band = u_material_bands[i];
+    float weight = smoothstep(band.x, band.y, h) - smoothstep(band.z, band.w, h);
+    if (u_material_slope[i] == SLOPE_FLAT)
+    {
+        weight *= 1.0 - slope_bias;
+    }
+    else if (u_material_slope[i] == SLOPE_STEEP)
+    {
+        weight = max(weight, slope_bias);
+    }
+    return weight;
+}
+
 void main()
 {
-   // sample svih teksturea
-    vec4 sand  = texture(u_tex_sand,  v_texcoord * 10.0);
-    vec4 grass = texture(u_tex_grass, v_texcoord * 10.0);
-    vec4 rock  = texture(u_tex_rock,  v_texcoord * 10.0);
-    vec4 snow  = texture(u_tex_snow,  v_texcoord * 10.0);
-    
-    // normalizujemo visinu i na osnovu nje racunamo uticaj teksture
-    float h = (v_height + 15.0) / 30.0;
-    
-    float sand_weight  = 1.0 - smoothstep(0.2, 0.35, h);
-    float grass_weight = smoothstep(0.2, 0.35, h) - smoothstep(0.5, 0.65, h);
-    float rock_weight  = smoothstep(0.5, 0.65, h) - smoothstep(0.8, 0.9, h);
-    float snow_weight  = smoothstep(0.8, 0.9, h);
-    
-    // 0 ravno, 1 vertikalno
+    if (u_depth_only == 1)
+    {
+        frag_color = vec4(0.0);
+        return;
+    }
+    if (u_overdraw == 1)
+    {
+        frag_color = OVERDRAW_COLOR;
+        return;
+    }
+
     vec3 N = normalize(v_normal);
-    float slope = 1.0 - clamp(abs(dot(N, vec3(0.0, 1.0, 0.0))), 0.0, 1.0);
-
-    // prednost rock teksture na terenu sa vecim slopeom
-    float slope_bias = smoothstep(0.35, 0.75, slope);
-    rock_weight = max(rock_weight, slope_bias);
-    float flat_bias = 1.0 - slope_bias;
-    sand_weight *= flat_bias;
-    grass_weight *= flat_bias;
-
-    float total_weight = sand_weight + grass_weight + rock_weight + snow_weight;
-    vec4 terrain_color =
-        (sand  * sand_weight  +
-         grass * grass_weight +
-         rock  * rock_weight  +
-         snow  * snow_weight) / max(total_weight, 0.0001);
+
+    // izvodi pre grananja: sused koji preskoci sloj bi inace pokvario izbor mip nivoa
+    vec2 uv = v_texcoord * 10.0;
+    vec2 uv_dx = dFdx(uv);
+    vec2 uv_dy = dFdy(uv);
+
+    // uzorkuju se samo slojevi sa tezinom vecom od nule, obicno jedan ili dva
+    vec4 terrain_color = vec4(0.0);
+    float total_weight = 0.0;
+    if (u_use_splat == 1)
+    {
+        // texel (col, row) je vertex grida, a v_texcoord = (col, row) / velicina
+        vec2 splat_uv = v_texcoord + 0.5 / vec2(textureSize(u_splat, 0).xy);
+        for (int layer = 0; layer < u_splat_layers; ++layer)
+        {
+            vec4 weights = texture(u_splat, vec3(splat_uv, float(layer)));
+            for (int c = 0; c < 4; ++c)
+            {
+                if (weights[c] > 0.0)
+                {
+                    terrain_color += textureGrad(u_materials, vec3(uv, float(layer * 4 + c)), uv_dx, uv_dy) * weights[c];
+                    total_weight += weights[c];
+                }
+            }
+        }
+    }
+    else
+    {
+        // normalizujemo visinu i na osnovu nje racunamo uticaj teksture
+        float h = (v_height + 15.0) / 30.0;
+
+        // 0 ravno, 1 vertikalno; prednost rock teksture na terenu sa vecim slopeom
+        float slope = 1.0 - clamp(abs(dot(N, vec3(0.0, 1.0, 0.0))), 0.0, 1.0);
+        float slope_bias = smoothstep(0.35, 0.75, slope);
+
+        for (int i = 0; i < u_material_count; ++i)
+        {
+            float weight = material_weight(i, h, slope_bias);
+            if (weight > 0.0)
+            {
+                terrain_color += textureGrad(u_materials, vec3(uv, float(i)), uv_dx, uv_dy) * weight;
+                total_weight += weight;
+            }
+        }
+    }
+    terrain_color /= max(total_weight, 0.0001);
     
     
     // koliko je povrsina okrenuta svetlu
     float diffuse = max(dot(N, u_light_dir), 0.0);
+    if (diffuse > 0.0)
+    {
+        diffuse *= shadow_factor(v_world_pos, N);
+    }
     
     vec3 lighting = u_ambient_color + diffuse * u_light_color;
     
@@ -1,19 +1,153 @@
 #version 330 core
 
+// FULL format
 layout(location = 0) in vec3 a_position;
 layout(location = 1) in vec2 a_texcoord;
 layout(location = 2) in vec3 a_normal;
 
+// COMPACT format: samo visina i normala, ostalo iz gl_VertexID
+layout(location = 3) in float a_height;     // unorm16
+layout(location = 4) in vec2 a_oct_normal;  // snorm8, oktaedarski oko y ose
+
 uniform mat4 u_MVP;
 
+uniform int u_vertex_format; // 0 = full, 1 = compact, 2 = heightmap, 3 = quadtree (CDLOD)
+uniform int u_patch_size;
+uniform int u_patch_cols;
+uniform int u_block_vertices; // PATCH_BLOCK_VERTICES, skirtovi su opcioni
+uniform int u_grid_size;
+uniform float u_spacing;
+uniform vec2 u_height_range; // min, opseg
+uniform float u_skirt_depth;
+
+// HEIGHTMAP format: R16 visine u istom opsegu kao compact
+uniform sampler2D u_heightmap;
+
+// CDLOD: jedan texel (col, row, velicina celije, nivo) po crtanju, bira se preko gl_VertexID
+uniform samplerBuffer u_nodes;
+uniform vec2 u_morph_ranges[16]; // TERRAIN_QUADTREE_MAX_LEVELS
+uniform vec3 u_camera_pos;
+uniform int u_grid_max;          // poslednja celija pokrivena patchovima
+
 out vec2 v_texcoord;
 out float v_height;
 out vec3 v_normal;
+out vec3 v_world_pos;
+
+vec3 decode_normal(vec2 e)
+{
+    vec3 n = vec3(e.x, 1.0 - abs(e.x) - abs(e.y), e.y);
+    if (n.y < 0.0) {
+        vec2 s = vec2(greaterThanEqual(n.xz, vec2(0.0))) * 2.0 - 1.0;
+        n.xz = (1.0 - abs(n.zx)) * s;
+    }
+    return normalize(n);
+}
+
+float grid_height(int row, int col)
+{
+    ivec2 texel = clamp(ivec2(col, row), ivec2(0), ivec2(u_grid_size - 1));
+    return u_height_range.x + texelFetch(u_heightmap, texel, 0).r * u_height_range.y;
+}
+
+// isto kao grid_normal u terrain.c
+vec3 grid_normal(int row, int col)
+{
+    float nx = grid_height(row, col - 1) - grid_height(row, col + 1);
+    float nz = grid_height(row - 1, col) - grid_height(row + 1, col);
+    return normalize(vec3(nx, 2.0 * u_spacing, nz));
+}
+
+// red/kolona unutar bloka, isti raspored kao terrain_block_build_skirts
+ivec2 block_cell(int local)
+{
+    int stride = u_patch_size + 1;
+    int grid_vertices = stride * stride;
+    if (local < grid_vertices) {
+        return ivec2(local / stride, local % stride);
+    }
+
+    int skirt = local - grid_vertices;
+    int edge = skirt / stride;
+    int i = skirt % stride;
+    if (edge == 0) return ivec2(0, i);
+    if (edge == 1) return ivec2(i, u_patch_size);
+    if (edge == 2) return ivec2(u_patch_size, u_patch_size - i);
+    return ivec2(u_patch_size - i, 0);
+}
 
 void main()
 {
-    gl_Position = u_MVP * vec4(a_position, 1.0);
-    v_texcoord = a_texcoord;
-    v_height = a_position.y;
-    v_normal = a_normal;
+    vec3 position = a_position;
+    vec2 texcoord = a_texcoord;
+    vec3 normal = a_normal;
+
+    if (u_vertex_format == 3) {
+        int stride = u_patch_size + 1;
+        int draw_index = gl_VertexID / u_block_vertices;
+        int local = gl_VertexID - draw_index * u_block_vertices;
+        ivec2 cell = block_cell(local);
+        vec4 node = texelFetch(u_nodes, draw_index);
+
+        ivec2 origin = ivec2(node.xy);
+        int quad = 1 << int(node.w);
+        ivec2 grid = origin + ivec2(cell.y, cell.x) * int(node.z);
+        // neparni vertexi grida ovog nivoa klize ka parnom, pa je na kraju
+        // opsega mreza ista kao kod sledeceg (grubljeg) nivoa
+        ivec2 target = grid - (((grid - origin) / quad) & 1) * quad;
+        // deo cvora van terena se skuplja na ivicu (degenerisani trouglovi)
+        grid = min(grid, ivec2(u_grid_max));
+        target = min(target, ivec2(u_grid_max));
+
+        float offset = float(u_grid_size - 1) * u_spacing * 0.5;
+        float grid_h = grid_height(grid.y, grid.x);
+        vec3 unmorphed = vec3(float(grid.x) * u_spacing - offset, grid_h, float(grid.y) * u_spacing - offset);
+        vec2 morph_range = u_morph_ranges[int(node.w)];
+        float morph = clamp((distance(u_camera_pos, unmorphed) - morph_range.x) / (morph_range.y - morph_range.x), 0.0, 1.0);
+
+        vec2 morphed = mix(vec2(grid), vec2(target), morph);
+        float height = mix(grid_h, grid_height(target.y, target.x), morph);
+        normal = normalize(mix(grid_normal(grid.y, grid.x), grid_normal(target.y, target.x), morph));
+        if (local >= stride * stride) {
+            height -= u_skirt_depth;
+            normal = vec3(0.0, -1.0, 0.0);
+        }
+
+        position = vec3(morphed.x * u_spacing - offset, height, morphed.y * u_spacing - offset);
+        texcoord = morphed / float(u_grid_size);
+    } else if (u_vertex_format != 0) {
+        // gl_VertexID ukljucuje base vertex, a blokovi patchova idu redom
+        int stride = u_patch_size + 1;
+        int patch_index = gl_VertexID / u_block_vertices;
+        int local = gl_VertexID - patch_index * u_block_vertices;
+        ivec2 cell = block_cell(local);
+
+        int row = min((patch_index / u_patch_cols) * u_patch_size + cell.x, u_grid_size - 1);
+        int col = min((patch_index % u_patch_cols) * u_patch_size + cell.y, u_grid_size - 1);
+        float offset = float(u_grid_size - 1) * u_spacing * 0.5;
+
+        float height;
+        if (u_vertex_format == 1) {
+            height = u_height_range.x + a_height * u_height_range.y;
+            normal = decode_normal(a_oct_normal);
+        } else if (local >= stride * stride) {
+            // skirt
+            height = grid_height(row, col) - u_skirt_depth;
+            normal = vec3(0.0, -1.0, 0.0);
+        } else {
+            height = grid_height(row, col);
+            normal = grid_normal(row, col);
+        }
+
+        position = vec3(float(col) * u_spacing - offset,
+                        height,
+                        float(row) * u_spacing - offset);
+        texcoord = vec2(col, row) / float(u_grid_size);
+    }
+
+    gl_Position = u_MVP * vec4(position, 1.0);
+    v_texcoord = texcoord;
+    v_height = position.y;
+    v_normal = normal;
+    v_world_pos = position;
 }
@@ -2,6 +2,7 @@
 
 in vec3 v_world_pos;
 in vec3 v_normal;
+in vec2 v_leaf;
 
 out vec4 frag_color;
 
@@ -10,19 +11,63 @@ uniform vec3 u_light_color;
 uniform vec3 u_ambient_color;
 uniform vec3 u_trunk_color;
 uniform vec3 u_leaf_color;
-uniform float u_leaf_start_height;
-uniform float u_leaf_transition_height;
+// depth pre-pass i shadow pass ne pisu boju, isto kao u shaderu terena
+uniform int u_depth_only;
+uniform int u_overdraw;
+
+// kaskadne senke, isto kao u shaderu terena
+#define MAX_CASCADES 4
+uniform sampler2DArrayShadow u_shadow_map;
+uniform int u_shadow_cascades;
+uniform mat4 u_shadow_matrices[MAX_CASCADES]; // svet -> [0, 1]
+uniform float u_shadow_texel[MAX_CASCADES];   // velicina texela u svetu
+
+float shadow_factor(vec3 world_pos, vec3 N)
+{
+    for (int i = 0; i < u_shadow_cascades; ++i)
+    {
+        vec3 p = (u_shadow_matrices[i] * vec4(world_pos + N * (1.5 * u_shadow_texel[i]), 1.0)).xyz;
+        if (all(greaterThan(p, vec3(0.0))) && all(lessThan(p, vec3(1.0))))
+        {
+            vec2 texel = 1.0 / vec2(textureSize(u_shadow_map, 0).xy);
+            float lit = texture(u_shadow_map, vec4(p.xy + vec2(-0.5, -0.5) * texel, float(i), p.z))
+                      + texture(u_shadow_map, vec4(p.xy + vec2( 0.5, -0.5) * texel, float(i), p.z))
+                      + texture(u_shadow_map, vec4(p.xy + vec2(-0.5,  0.5) * texel, float(i), p.z))
+                      + texture(u_shadow_map, vec4(p.xy + vec2( 0.5,  0.5) * texel, float(i), p.z));
+            return lit * 0.25;
+        }
+    }
+    return 1.0;
+}
+
+// isto kao OVERDRAW_COLOR u shaderu terena
+const vec4 OVERDRAW_COLOR = vec4(0.2, 0.1, 0.04, 1.0);
 
 void main()
 {
+    if (u_depth_only == 1)
+    {
+        frag_color = vec4(0.0);
+        return;
+    }
+    if (u_overdraw == 1)
+    {
+        frag_color = OVERDRAW_COLOR;
+        return;
+    }
+
     vec3 N = normalize(v_normal);
 
     // isto kao za teren
     float diffuse = max(dot(N, normalize(u_light_dir)), 0.0);
+    if (diffuse > 0.0)
+    {
+        diffuse *= shadow_factor(v_world_pos, N);
+    }
     vec3 lighting = u_ambient_color + diffuse * u_light_color;
 
-    float mix_value = smoothstep(u_leaf_start_height,
-                                 u_leaf_start_height + u_leaf_transition_height,
+    float mix_value = smoothstep(v_leaf.x,
+                                 v_leaf.x + v_leaf.y,
                                  v_world_pos.y);
     vec3 base_color = mix(u_trunk_color, u_leaf_color, clamp(mix_value, 0.0, 1.0));
 
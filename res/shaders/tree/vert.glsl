@@ -4,17 +4,22 @@ layout(location = 0) in vec3 a_position;
 layout(location = 1) in vec2 a_texcoord;
 layout(location = 2) in vec3 a_normal;
 
-uniform mat4 u_MVP;
-uniform mat4 u_model;
-uniform mat3 u_normal_matrix;
+// po instanci (divisor 1), mat4 zauzima lokacije 3-6, mat3 7-9
+layout(location = 3) in mat4 a_model;
+layout(location = 7) in mat3 a_normal_matrix;
+layout(location = 10) in vec2 a_leaf; // x = pocetak krosnje, y = prelaz
+
+uniform mat4 u_view_projection;
 
 out vec3 v_world_pos;
 out vec3 v_normal;
+out vec2 v_leaf;
 
 void main()
 {
-    vec4 world_pos = u_model * vec4(a_position, 1.0);
+    vec4 world_pos = a_model * vec4(a_position, 1.0);
     v_world_pos = world_pos.xyz;
-    v_normal = normalize(u_normal_matrix * a_normal);
-    gl_Position = u_MVP * vec4(a_position, 1.0);
+    v_normal = normalize(a_normal_matrix * a_normal);
+    v_leaf = a_leaf;
+    gl_Position = u_view_projection * world_pos;
 }
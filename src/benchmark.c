@@ -0,0 +1,471 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <glad/glad.h>
+#include <GLFW/glfw3.h>
+#ifdef TERRAIN_EGL
+#define EGL_NO_X11
+#include <EGL/egl.h>
+#include <EGL/eglext.h>
+#endif
+#include <rafgl.h>
+#include <benchmark.h>
+#include <main_state.h>
+#include <camera.h>
+#include <profiler.h>
+#include <terrain_draw.h>
+
+// ugradjena putanja: krug preko fiksnog terena sa spustanjem ka dolini i penjanjem iznad vrhova
+static const float default_path[][3] = {
+    {    0.0f,  60.0f,  300.0f },
+    {  210.0f,  60.0f,  210.0f },
+    {  300.0f,  80.0f,    0.0f },
+    {  210.0f, 120.0f, -210.0f },
+    {    0.0f,  70.0f, -300.0f },
+    { -210.0f,  55.0f, -210.0f },
+    { -300.0f,  55.0f,    0.0f },
+    { -150.0f,  90.0f,  150.0f },
+};
+
+typedef struct {
+    float *frame_ms;
+    double total_ms;
+    long long triangles;   // zbir preko merenih frejmova, isti za isti seed i putanju
+    long long draw_calls;
+    int max_triangles;
+    int max_draw_calls;
+    double overdraw;        // zbir RenderStats.overdraw
+    double context_ms;
+    double state_init_ms;
+    double first_frame_ms;  // od pocetka main_state_init do kraja prvog frejma
+} BenchmarkResults;
+
+typedef struct {
+    GLFWwindow *window;    // NULL za EGL, main_state ga koristi samo za ESC
+#ifdef TERRAIN_EGL
+    EGLDisplay display;
+    EGLSurface surface;
+    EGLContext context;
+#endif
+} BenchmarkContext;
+
+static double now_ms(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000.0 + ts.tv_nsec / 1000000.0;
+}
+
+int benchmark_parse_args(int argc, char *argv[], BenchmarkConfig *config)
+{
+    int enabled = 0;
+    memset(config, 0, sizeof(*config));
+    config->frames = BENCHMARK_DEFAULT_FRAMES;
+    config->warmup_frames = BENCHMARK_DEFAULT_WARMUP;
+    config->width = 800;
+    config->height = 600;
+    config->seed = 1337u;
+    config->tolerance = BENCHMARK_DEFAULT_TOLERANCE;
+
+    for (int i = 1; i < argc; ++i) {
+        const char *arg = argv[i];
+        const char *value = i + 1 < argc ? argv[i + 1] : NULL;
+        if (strcmp(arg, "--benchmark") == 0) {
+            enabled = 1;
+        } else if (!value) {
+            fprintf(stderr, "Benchmark: %s needs a value\n", arg);
+        } else if (strcmp(arg, "--frames") == 0) {
+            config->frames = atoi(argv[++i]);
+        } else if (strcmp(arg, "--warmup") == 0) {
+            config->warmup_frames = atoi(argv[++i]);
+        } else if (strcmp(arg, "--size") == 0) {
+            sscanf(argv[++i], "%dx%d", &config->width, &config->height);
+        } else if (strcmp(arg, "--seed") == 0) {
+            config->seed = (uint32_t)strtoul(argv[++i], NULL, 10);
+        } else if (strcmp(arg, "--path") == 0) {
+            config->path_file = argv[++i];
+        } else if (strcmp(arg, "--out") == 0) {
+            config->output_path = argv[++i];
+        } else if (strcmp(arg, "--baseline") == 0) {
+            config->baseline_path = argv[++i];
+        } else if (strcmp(arg, "--tolerance") == 0) {
+            config->tolerance = strtof(argv[++i], NULL);
+        }
+    }
+
+    if (config->frames < 1) config->frames = 1;
+    if (config->warmup_frames < 0) config->warmup_frames = 0;
+    return enabled;
+}
+
+static int compare_floats(const void *a, const void *b)
+{
+    float fa = *(const float *)a;
+    float fb = *(const float *)b;
+    return (fa > fb) - (fa < fb);
+}
+
+// sorted mora biti rastuce sortiran
+static float percentile(const float *sorted, int count, float p)
+{
+    int index = (int)(p * (count - 1) + 0.5f);
+    return sorted[index];
+}
+
+static void write_json(FILE *out, const BenchmarkConfig *config, const BenchmarkResults *results, const float *sorted)
+{
+    int n = config->frames;
+    double avg = results->total_ms / n;
+
+    fprintf(out, "{\n");
+    fprintf(out, "  \"seed\": %u,\n", config->seed);
+    fprintf(out, "  \"frames\": %d,\n", n);
+    fprintf(out, "  \"warmup_frames\": %d,\n", config->warmup_frames);
+    fprintf(out, "  \"width\": %d,\n", config->width);
+    fprintf(out, "  \"height\": %d,\n", config->height);
+    fprintf(out, "  \"renderer\": \"%s\",\n", (const char *)glGetString(GL_RENDERER));
+    fprintf(out, "  \"frame_ms\": {\n");
+    fprintf(out, "    \"avg_ms\": %.3f,\n", avg);
+    fprintf(out, "    \"min_ms\": %.3f,\n", sorted[0]);
+    fprintf(out, "    \"p50_ms\": %.3f,\n", percentile(sorted, n, 0.50f));
+    fprintf(out, "    \"p90_ms\": %.3f,\n", percentile(sorted, n, 0.90f));
+    fprintf(out, "    \"p95_ms\": %.3f,\n", percentile(sorted, n, 0.95f));
+    fprintf(out, "    \"p99_ms\": %.3f,\n", percentile(sorted, n, 0.99f));
+    fprintf(out, "    \"max_ms\": %.3f,\n", sorted[n - 1]);
+    fprintf(out, "    \"avg_fps\": %.2f\n", avg > 0.0 ? 1000.0 / avg : 0.0);
+    fprintf(out, "  },\n");
+    fprintf(out, "  \"draw_calls\": { \"avg\": %.2f, \"max\": %d, \"total\": %lld },\n",
+            (double)results->draw_calls / n, results->max_draw_calls, results->draw_calls);
+    fprintf(out, "  \"triangles\": { \"avg\": %.1f, \"max\": %d, \"total\": %lld },\n",
+            (double)results->triangles / n, results->max_triangles, results->triangles);
+    fprintf(out, "  \"overdraw\": { \"avg\": %.3f },\n", results->overdraw / n);
+
+    // profiler pamti poslednjih PROFILER_HISTORY frejmova
+    fprintf(out, "  \"scopes\": {\n");
+    for (int i = 0; i < PROFILE_SCOPE_COUNT; ++i) {
+        ProfileStats cpu, gpu;
+        profiler_stats(i, 0, &cpu);
+        profiler_stats(i, 1, &gpu);
+        fprintf(out, "    \"%s\": { \"cpu_avg_ms\": %.3f, \"cpu_p99_ms\": %.3f, \"gpu_avg_ms\": %.3f, \"gpu_p99_ms\": %.3f }%s\n",
+                profiler_scope_name(i), cpu.avg_ms, cpu.p99_ms, gpu.avg_ms, gpu.p99_ms,
+                i + 1 < PROFILE_SCOPE_COUNT ? "," : "");
+    }
+    fprintf(out, "  },\n");
+    fprintf(out, "  \"init_ms\": {\n");
+    fprintf(out, "    \"context\": %.3f,\n", results->context_ms);
+    fprintf(out, "    \"state\": %.3f,\n", results->state_init_ms);
+    fprintf(out, "    \"first_frame\": %.3f,\n", results->first_frame_ms);
+    fprintf(out, "    \"phases\": {\n");
+    int phase_count = profiler_phase_count();
+    for (int i = 0; i < phase_count; ++i) {
+        const ProfilePhase *phase = profiler_phase_get(i);
+        fprintf(out, "      \"%s\": { \"start\": %.3f, \"duration\": %.3f, \"worker\": %s }%s\n",
+                phase->name, phase->start_ms, phase->end_ms - phase->start_ms,
+                phase->on_worker ? "true" : "false", i + 1 < phase_count ? "," : "");
+    }
+    fprintf(out, "    }\n");
+    fprintf(out, "  }\n");
+    fprintf(out, "}\n");
+}
+
+// dovoljno za JSON koji pise write_json: prvo pojavljivanje kljuca posle sekcije
+static int json_number(const char *text, const char *section, const char *key, double *out)
+{
+    const char *start = section ? strstr(text, section) : text;
+    if (!start) {
+        return 0;
+    }
+    char pattern[64];
+    snprintf(pattern, sizeof(pattern), "\"%s\":", key);
+    const char *found = strstr(start, pattern);
+    return found && sscanf(found + strlen(pattern), "%lf", out) == 1;
+}
+
+static char *read_file(const char *path)
+{
+    FILE *file = fopen(path, "rb");
+    if (!file) {
+        return NULL;
+    }
+    fseek(file, 0, SEEK_END);
+    long size = ftell(file);
+    fseek(file, 0, SEEK_SET);
+    char *text = malloc(size + 1);
+    size_t read = fread(text, 1, size, file);
+    text[read] = '\0';
+    fclose(file);
+    return text;
+}
+
+// 0 ako nema regresije; brojevi trouglova i crtanja moraju da se poklope tacno
+static int compare_with_baseline(const BenchmarkConfig *config, const BenchmarkResults *results, const float *sorted)
+{
+    char *baseline = read_file(config->baseline_path);
+    if (!baseline) {
+        fprintf(stderr, "Benchmark: no baseline at %s (record one with `make bench-baseline`)\n", config->baseline_path);
+        return 0;
+    }
+
+    int failed = 0;
+    double base_triangles, base_draws;
+    if (!json_number(baseline, "\"triangles\"", "total", &base_triangles) ||
+        !json_number(baseline, "\"draw_calls\"", "total", &base_draws)) {
+        fprintf(stderr, "Benchmark: %s is not a benchmark result\n", config->baseline_path);
+        free(baseline);
+        return 1;
+    }
+    if ((long long)base_triangles != results->triangles || (long long)base_draws != results->draw_calls) {
+        fprintf(stderr, "Benchmark: scene differs from baseline (triangles %lld vs %.0f, draw calls %lld vs %.0f), "
+                        "timings are not comparable\n",
+                results->triangles, base_triangles, results->draw_calls, base_draws);
+        failed = 1;
+    }
+
+    const char *keys[] = { "avg_ms", "p50_ms", "p99_ms" };
+    float current[] = { (float)(results->total_ms / config->frames),
+                        percentile(sorted, config->frames, 0.50f),
+                        percentile(sorted, config->frames, 0.99f) };
+    for (int i = 0; i < 3; ++i) {
+        double base;
+        if (!json_number(baseline, "\"frame_ms\"", keys[i], &base) || base <= 0.0) {
+            continue;
+        }
+        double change = (current[i] - base) / base;
+        int regressed = change > config->tolerance;
+        fprintf(stderr, "Benchmark: frame %s %.3f vs baseline %.3f (%+.1f%%)%s\n",
+                keys[i], current[i], base, change * 100.0, regressed ? "  REGRESSION" : "");
+        failed |= regressed;
+    }
+
+    free(baseline);
+    return failed;
+}
+
+#ifdef TERRAIN_EGL
+static void *egl_proc_address(const char *name)
+{
+    return (void *)eglGetProcAddress(name);
+}
+
+// bez prozora i displeja: surfaceless Mesa platforma (llvmpipe radi i bez GPU-a), inace podrazumevani EGL displej
+static int context_create(BenchmarkContext *context, int width, int height)
+{
+    memset(context, 0, sizeof(*context));
+    context->display = EGL_NO_DISPLAY;
+    PFNEGLGETPLATFORMDISPLAYEXTPROC get_platform_display =
+        (PFNEGLGETPLATFORMDISPLAYEXTPROC)eglGetProcAddress("eglGetPlatformDisplayEXT");
+    if (get_platform_display) {
+        context->display = get_platform_display(EGL_PLATFORM_SURFACELESS_MESA, EGL_DEFAULT_DISPLAY, NULL);
+    }
+    if (context->display == EGL_NO_DISPLAY) {
+        context->display = eglGetDisplay(EGL_DEFAULT_DISPLAY);
+    }
+    if (context->display == EGL_NO_DISPLAY || !eglInitialize(context->display, NULL, NULL)) {
+        fprintf(stderr, "Benchmark: no EGL display\n");
+        return 0;
+    }
+
+    const EGLint config_attribs[] = {
+        EGL_SURFACE_TYPE, EGL_PBUFFER_BIT,
+        EGL_RENDERABLE_TYPE, EGL_OPENGL_BIT,
+        EGL_RED_SIZE, 8, EGL_GREEN_SIZE, 8, EGL_BLUE_SIZE, 8,
+        EGL_DEPTH_SIZE, 24,
+        EGL_NONE
+    };
+    EGLConfig egl_config;
+    EGLint config_count = 0;
+    if (!eglChooseConfig(context->display, config_attribs, &egl_config, 1, &config_count) || config_count < 1) {
+        fprintf(stderr, "Benchmark: no EGL config with desktop GL and a pbuffer\n");
+        eglTerminate(context->display);
+        return 0;
+    }
+    const EGLint surface_attribs[] = { EGL_WIDTH, width, EGL_HEIGHT, height, EGL_NONE };
+    context->surface = eglCreatePbufferSurface(context->display, egl_config, surface_attribs);
+
+    const EGLint context_attribs[] = {
+        EGL_CONTEXT_MAJOR_VERSION, 3,
+        EGL_CONTEXT_MINOR_VERSION, 3,
+        EGL_CONTEXT_OPENGL_PROFILE_MASK, EGL_CONTEXT_OPENGL_CORE_PROFILE_BIT,
+        EGL_NONE
+    };
+    eglBindAPI(EGL_OPENGL_API);
+    context->context = eglCreateContext(context->display, egl_config, EGL_NO_CONTEXT, context_attribs);
+    if (context->context == EGL_NO_CONTEXT ||
+        !eglMakeCurrent(context->display, context->surface, context->surface, context->context)) {
+        fprintf(stderr, "Benchmark: could not create a GL 3.3 core EGL context\n");
+        eglTerminate(context->display);
+        return 0;
+    }
+    eglSwapInterval(context->display, 0);
+
+    if (!gladLoadGLLoader((GLADloadproc)egl_proc_address)) {
+        fprintf(stderr, "Benchmark: failed to load GL functions\n");
+        eglTerminate(context->display);
+        return 0;
+    }
+    terrain_draw_set_proc_loader((GLADloadproc)egl_proc_address);
+    return 1;
+}
+
+static void context_destroy(BenchmarkContext *context)
+{
+    eglMakeCurrent(context->display, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+    eglDestroyContext(context->display, context->context);
+    if (context->surface != EGL_NO_SURFACE) {
+        eglDestroySurface(context->display, context->surface);
+    }
+    eglTerminate(context->display);
+}
+#else
+// bez EGL-a (macOS): skriveni GLFW prozor, i dalje treba displej
+static int context_create(BenchmarkContext *context, int width, int height)
+{
+    memset(context, 0, sizeof(*context));
+    if (!glfwInit()) {
+        fprintf(stderr, "Benchmark: GLFW init failed\n");
+        return 0;
+    }
+    // rafgl_game_init ne resetuje hintove, pa prozor ostaje skriven
+    glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
+
+    rafgl_game_t game;
+    if (rafgl_game_init(&game, "Terrain Benchmark", width, height, 0) != 0) {
+        return 0;
+    }
+    glfwSwapInterval(0);
+    context->window = game.window;
+    return 1;
+}
+
+static void context_destroy(BenchmarkContext *context)
+{
+    glfwDestroyWindow(context->window);
+    glfwTerminate();
+}
+#endif
+
+int benchmark_run(const BenchmarkConfig *config)
+{
+    BenchmarkResults results;
+    memset(&results, 0, sizeof(results));
+
+    // isti svet u svakom pokretanju, main_state cita seed iz okruzenja
+    char seed[16];
+    snprintf(seed, sizeof(seed), "%u", config->seed);
+    setenv("TERRAIN_SEED", seed, 1);
+
+    double start = now_ms();
+    BenchmarkContext context;
+    if (!context_create(&context, config->width, config->height)) {
+        fprintf(stderr, "Benchmark: could not create an offscreen GL context\n");
+        return 1;
+    }
+
+    // crta se u sopstveni FBO, surfaceless kontekst nema default framebuffer
+    GLuint fbo, color_rb, depth_rb;
+    glGenFramebuffers(1, &fbo);
+    glGenRenderbuffers(1, &color_rb);
+    glGenRenderbuffers(1, &depth_rb);
+    glBindRenderbuffer(GL_RENDERBUFFER, color_rb);
+    glRenderbufferStorage(GL_RENDERBUFFER, GL_RGBA8, config->width, config->height);
+    glBindRenderbuffer(GL_RENDERBUFFER, depth_rb);
+    glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT24, config->width, config->height);
+    glBindRenderbuffer(GL_RENDERBUFFER, 0);
+    glBindFramebuffer(GL_FRAMEBUFFER, fbo);
+    glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, color_rb);
+    glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, depth_rb);
+    if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE) {
+        fprintf(stderr, "Benchmark: offscreen framebuffer is incomplete\n");
+        return 1;
+    }
+    glViewport(0, 0, config->width, config->height);
+    results.context_ms = now_ms() - start;
+
+    double state_start = now_ms();
+    main_state_init(context.window, NULL, config->width, config->height);
+    glFinish();
+    results.state_init_ms = now_ms() - state_start;
+
+    CameraPath path;
+    path.count = 0;
+    if (config->path_file && camera_path_load(&path, config->path_file, BENCHMARK_PATH_DURATION) != 0) {
+        fprintf(stderr, "Benchmark: could not load camera path %s, using the built-in one\n", config->path_file);
+        path.count = 0;
+    }
+    if (path.count == 0) {
+        path.count = sizeof(default_path) / sizeof(default_path[0]);
+        path.duration = BENCHMARK_PATH_DURATION;
+        for (int i = 0; i < path.count; ++i) {
+            path.points[i] = vec3(default_path[i][0], default_path[i][1], default_path[i][2]);
+        }
+    }
+    main_state_set_camera_path(&path);
+
+    // bez unosa: tasteri nikad nisu pritisnuti
+    uint8_t keys_down[400] = {0}, keys_pressed[400] = {0};
+    rafgl_game_data_t game_data;
+    memset(&game_data, 0, sizeof(game_data));
+    game_data.keys_down = keys_down;
+    game_data.keys_pressed = keys_pressed;
+    game_data.raster_width = config->width;
+    game_data.raster_height = config->height;
+
+    results.frame_ms = malloc(config->frames * sizeof(float));
+    int total_frames = config->warmup_frames + config->frames;
+    for (int frame = 0; frame < total_frames; ++frame) {
+        double frame_start = now_ms();
+        main_state_update(context.window, BENCHMARK_FRAME_STEP, &game_data, NULL);
+        main_state_render(context.window, NULL);
+        // glFinish da vreme frejma ukljuci i GPU
+        glFinish();
+        double elapsed = now_ms() - frame_start;
+        if (frame == 0) {
+            results.first_frame_ms = now_ms() - state_start;
+        }
+
+        int measured = frame - config->warmup_frames;
+        if (measured < 0) {
+            continue;
+        }
+        const RenderStats *stats = main_state_render_stats();
+        results.frame_ms[measured] = (float)elapsed;
+        results.total_ms += elapsed;
+        results.triangles += stats->terrain_triangles;
+        results.draw_calls += stats->draw_calls;
+        results.overdraw += stats->overdraw;
+        if (stats->terrain_triangles > results.max_triangles) results.max_triangles = stats->terrain_triangles;
+        if (stats->draw_calls > results.max_draw_calls) results.max_draw_calls = stats->draw_calls;
+    }
+
+    float *sorted = malloc(config->frames * sizeof(float));
+    memcpy(sorted, results.frame_ms, config->frames * sizeof(float));
+    qsort(sorted, config->frames, sizeof(float), compare_floats);
+
+    write_json(stdout, config, &results, sorted);
+    if (config->output_path) {
+        FILE *out = fopen(config->output_path, "w");
+        if (out) {
+            write_json(out, config, &results, sorted);
+            fclose(out);
+        } else {
+            fprintf(stderr, "Benchmark: could not write %s\n", config->output_path);
+        }
+    }
+
+    int status = 0;
+    if (config->baseline_path) {
+        status = compare_with_baseline(config, &results, sorted);
+    }
+
+    main_state_set_camera_path(NULL);
+    main_state_cleanup(context.window, NULL);
+    glDeleteFramebuffers(1, &fbo);
+    glDeleteRenderbuffers(1, &color_rb);
+    glDeleteRenderbuffers(1, &depth_rb);
+    context_destroy(&context);
+
+    free(sorted);
+    free(results.frame_ms);
+    return status;
+}
@@ -29,6 +29,9 @@ void camera_init(Camera *camera, float aspect_ratio) {
     camera->last_mouse_x = 0.0f;
     camera->last_mouse_y = 0.0f;
     camera->first_mouse = 1;
+
+    camera->path = NULL;
+    camera->path_time = 0.0f;
     
     
     camera_update_vectors(camera);
@@ -44,7 +47,29 @@ void camera_init(Camera *camera, float aspect_ratio) {
            camera->yaw, camera->pitch);
 }
 
+static void camera_follow_path(Camera *camera, float delta_time) {
+    const CameraPath *path = camera->path;
+    camera->path_time += delta_time;
+    float t = fmodf(camera->path_time / path->duration, 1.0f);
+
+    // gleda ka tacki malo napred na putanji
+    vec3_t ahead = camera_path_sample(path, t + 0.01f);
+    camera->position = camera_path_sample(path, t);
+    vec3_t dir = v3_norm(v3_sub(ahead, camera->position));
+    camera->yaw = atan2f(dir.z, dir.x) * 180.0f / M_PIf;
+    camera->pitch = asinf(dir.y) * 180.0f / M_PIf;
+    camera_update_vectors(camera);
+
+    vec3_t target = v3_add(camera->position, camera->front);
+    camera->view = m4_look_at(camera->position, target, camera->up);
+}
+
 void camera_update(Camera *camera, float delta_time, rafgl_game_data_t *game_data) {
+    if (camera->path) {
+        camera_follow_path(camera, delta_time);
+        return;
+    }
+
     float speed = camera->move_speed * delta_time;
     
     float mouse_x = game_data->mouse_pos_x;
@@ -107,3 +132,54 @@ vec3_t camera_get_position(const Camera *camera)
 {
     return camera->position;
 }
+
+void camera_set_path(Camera *camera, const CameraPath *path)
+{
+    camera->path = path && path->count >= 4 ? path : NULL;
+    camera->path_time = 0.0f;
+}
+
+vec3_t camera_path_sample(const CameraPath *path, float t)
+{
+    t = t - floorf(t);
+    float segment = t * path->count;
+    int i = (int)segment;
+    float f = segment - i;
+
+    vec3_t p0 = path->points[(i + path->count - 1) % path->count];
+    vec3_t p1 = path->points[i % path->count];
+    vec3_t p2 = path->points[(i + 1) % path->count];
+    vec3_t p3 = path->points[(i + 2) % path->count];
+
+    // uniformni Catmull-Rom
+    float f2 = f * f, f3 = f2 * f;
+    float w0 = -0.5f * f3 + f2 - 0.5f * f;
+    float w1 = 1.5f * f3 - 2.5f * f2 + 1.0f;
+    float w2 = -1.5f * f3 + 2.0f * f2 + 0.5f * f;
+    float w3 = 0.5f * f3 - 0.5f * f2;
+    return vec3(p0.x * w0 + p1.x * w1 + p2.x * w2 + p3.x * w3,
+                p0.y * w0 + p1.y * w1 + p2.y * w2 + p3.y * w3,
+                p0.z * w0 + p1.z * w1 + p2.z * w2 + p3.z * w3);
+}
+
+int camera_path_load(CameraPath *path, const char *file_path, float duration)
+{
+    FILE *file = fopen(file_path, "r");
+    if (!file) {
+        return -1;
+    }
+
+    char line[256];
+    path->count = 0;
+    path->duration = duration;
+    while (fgets(line, sizeof(line), file) && path->count < CAMERA_PATH_MAX_POINTS) {
+        float x, y, z;
+        if (line[0] == '#' || sscanf(line, "%f %f %f", &x, &y, &z) != 3) {
+            continue;
+        }
+        path->points[path->count++] = vec3(x, y, z);
+    }
+    fclose(file);
+
+    return path->count >= 4 ? 0 : -1;
+}
@@ -0,0 +1,72 @@
+#include <frustum.h>
+#include <math.h>
+
+static FrustumPlane plane_normalized(float a, float b, float c, float d)
+{
+    float length = sqrtf(a * a + b * b + c * c);
+    if (length > 0.0f) {
+        a /= length;
+        b /= length;
+        c /= length;
+        d /= length;
+    }
+    return (FrustumPlane){ a, b, c, d };
+}
+
+void frustum_from_matrix(Frustum *frustum, mat4_t m)
+{
+    // Gribb/Hartmann: red i matrice je (m0i, m1i, m2i, m3i), ravni su red3 +- red0..2
+    for (int i = 0; i < 3; ++i) {
+        float a = m.m[0][i], b = m.m[1][i], c = m.m[2][i], d = m.m[3][i];
+        frustum->planes[i * 2 + 0] = plane_normalized(m.m03 + a, m.m13 + b, m.m23 + c, m.m33 + d);
+        frustum->planes[i * 2 + 1] = plane_normalized(m.m03 - a, m.m13 - b, m.m23 - c, m.m33 - d);
+    }
+}
+
+int frustum_test_aabb(const Frustum *frustum, vec3_t min, vec3_t max)
+{
+    for (int i = 0; i < 6; ++i) {
+        const FrustumPlane *p = &frustum->planes[i];
+        // ugao kutije najdalji u smeru normale, ako je on napolju cela kutija je napolju
+        float x = p->a >= 0.0f ? max.x : min.x;
+        float y = p->b >= 0.0f ? max.y : min.y;
+        float z = p->c >= 0.0f ? max.z : min.z;
+        if (p->a * x + p->b * y + p->c * z + p->d < 0.0f) {
+            return 0;
+        }
+    }
+    return 1;
+}
+
+FrustumClass frustum_classify_aabb(const Frustum *frustum, vec3_t min, vec3_t max)
+{
+    FrustumClass result = FRUSTUM_INSIDE;
+    for (int i = 0; i < 6; ++i) {
+        const FrustumPlane *p = &frustum->planes[i];
+        float far_x = p->a >= 0.0f ? max.x : min.x;
+        float far_y = p->b >= 0.0f ? max.y : min.y;
+        float far_z = p->c >= 0.0f ? max.z : min.z;
+        if (p->a * far_x + p->b * far_y + p->c * far_z + p->d < 0.0f) {
+            return FRUSTUM_OUTSIDE;
+        }
+        // i najblizi ugao unutra znaci da je cela kutija sa unutrasnje strane ravni
+        float near_x = p->a >= 0.0f ? min.x : max.x;
+        float near_y = p->b >= 0.0f ? min.y : max.y;
+        float near_z = p->c >= 0.0f ? min.z : max.z;
+        if (p->a * near_x + p->b * near_y + p->c * near_z + p->d < 0.0f) {
+            result = FRUSTUM_INTERSECTS;
+        }
+    }
+    return result;
+}
+
+int frustum_test_sphere(const Frustum *frustum, vec3_t center, float radius)
+{
+    for (int i = 0; i < 6; ++i) {
+        const FrustumPlane *p = &frustum->planes[i];
+        if (p->a * center.x + p->b * center.y + p->c * center.z + p->d < -radius) {
+            return 0;
+        }
+    }
+    return 1;
+}
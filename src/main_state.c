@@ -1,33 +1,67 @@
 #include <main_state.h>
 #include <glad/glad.h>
 #include <math.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stddef.h>
 #include <vertex.h>
 #include <terrain.h>
 #include <rafgl.h>
 #include <camera.h>
 #include <noise.h>
 #include <texture.h>
+#include <texture_stream.h>
 #include <tree.h>
 #include <water.h>
+#include <thread_pool.h>
+#include <terrain_stream.h>
+#include <terrain_quadtree.h>
+#include <terrain_draw.h>
+#include <profiler.h>
+#include <shadow.h>
 
 static int window_width, window_height;
 
 static GLuint vao;
 static GLuint vbo;
+static TerrainLodIndices terrain_indices;
+static int *patch_lods; // LOD svakog patcha u trenutnom frejmu
+static TerrainDrawList terrain_draws; // vidljivi patchovi/cvorovi, jedan multi-draw po frejmu
+static float lod_pixel_tolerance;
+
+// TERRAIN_CDLOD=1: quadtree nad heightmap teksturom umesto liste patchova
+static TerrainQuadtree quadtree;
+static int use_quadtree = 0;
+static GLint u_camera_pos_loc;
 static GLuint shader_program;
 static GLint u_MVP_location;
+static GLint u_vertex_format_loc;
+static GLuint heightmap_texture; // samo u HEIGHTMAP formatu
+static GLint u_heightmap_loc;
 
 // skybox
 static GLuint skybox_vao;
 static GLuint skybox_vbo;
 static GLuint skybox_program;
-static GLuint skybox_texture;
+static int skybox_texture; // id u texture_stream
 static GLint skybox_view_loc;
 static GLint skybox_proj_loc;
 
 // textre 
-static GLuint tex_sand, tex_grass, tex_rock, tex_snow;
-static GLint tex_sand_loc, tex_grass_loc, tex_rock_loc, tex_snow_loc;
+static TextureStream texture_stream;
+
+// materijali terena su slojevi jednog GL_TEXTURE_2D_ARRAY, novi materijal je novi red ovde
+// (do TERRAIN_MAX_MATERIALS)
+static const TerrainMaterial terrain_materials[] = {
+    { "res/textures/sand.png",  { -1000.0f, -999.0f, 0.2f, 0.35f },  TERRAIN_SLOPE_FLAT },
+    { "res/textures/grass.png", { 0.2f, 0.35f, 0.5f, 0.65f },        TERRAIN_SLOPE_FLAT },
+    { "res/textures/rock.png",  { 0.5f, 0.65f, 0.8f, 0.9f },         TERRAIN_SLOPE_STEEP },
+    { "res/textures/snow.png",  { 0.8f, 0.9f, 1000.0f, 1001.0f },    TERRAIN_SLOPE_ANY },
+};
+static const int terrain_material_count = sizeof(terrain_materials) / sizeof(terrain_materials[0]);
+static int material_texture; // id u texture_stream, placeholder dok se ucitava
+static TerrainSplatMap splat_map; // tezine materijala fiksnog terena
+static GLint u_use_splat_loc;
 
 // light
 static GLint u_light_dir_loc, u_light_color_loc, u_ambient_color_loc;
@@ -38,6 +72,65 @@ static Camera camera;
 static TreeSystem tree_system;
 static Water water;
 
+// G prebacuje izmedju fiksnog terena i beskonacnog sveta od chunkova
+static TerrainStream terrain_stream;
+static int streaming_world = 0;
+
+// brojaci poslednjeg frejma, C ih ispisuje, a benchmark cita
+static RenderStats render_stats;
+
+// Z (ili TERRAIN_DEPTH_PREPASS=1): teren i drvece se prvo crtaju samo u depth,
+// pa skupi fragment shader radi jednom po pikselu
+static int depth_prepass = 0;
+// V (ili TERRAIN_OVERDRAW=1): umesto scene svetlina pokazuje koliko puta je piksel sencen
+static int overdraw_view = 0;
+static GLint u_depth_only_loc, u_overdraw_loc;
+// GL_SAMPLES_PASSED oko color passa terena i drveca, cita se kasnije kao u profileru
+static GLuint overdraw_queries[PROFILER_QUERY_BUFFERS];
+static int overdraw_query_pending[PROFILER_QUERY_BUFFERS];
+static int overdraw_query_active;
+static long render_frame;
+
+// senke sunca; TERRAIN_SHADOW_CASCADES i TERRAIN_SHADOW_RESOLUTION menjaju kvalitet i cenu
+static ShadowMap shadow_map;
+static ShadowUniforms terrain_shadow_uniforms;
+static TerrainDrawList shadow_draws; // lista jedne kaskade, ponovo se puni za svaku
+
+// TERRAIN_SEED=<n> menja svet, isti seed uvek daje isti teren i drvece
+static const uint32_t DEFAULT_WORLD_SEED = 1337u;
+static uint32_t world_seed;
+
+// CPU deo ucitavanja (OBJ, raspored drveca) ide na worker niti dok glavna
+// generise teren, teksture stizu kroz texture_stream posle prvog frejma
+static const char *skybox_faces[6] = {
+    "res/textures/skybox/right.png",
+    "res/textures/skybox/left.png",
+    "res/textures/skybox/top.png",
+    "res/textures/skybox/bottom.png",
+    "res/textures/skybox/front.png",
+    "res/textures/skybox/back.png"
+};
+
+static ThreadPoolGroup tree_mesh_group;
+static int first_frame_pending;
+static int textures_pending;
+
+static void tree_mesh_job(void *user)
+{
+    int phase = profiler_phase_begin("tree mesh");
+    tree_system_load_mesh(user);
+    profiler_phase_end(phase);
+}
+
+static void tree_place_job(void *user)
+{
+    // bounds instanci zavise od mesha
+    thread_pool_wait(thread_pool_shared(), &tree_mesh_group);
+    int phase = profiler_phase_begin("tree placement");
+    tree_system_place(user, &terrain, world_seed);
+    profiler_phase_end(phase);
+}
+
 static const float skybox_vertices[] = {
     -1.0f,  1.0f, -1.0f,
     -1.0f, -1.0f, -1.0f,
@@ -84,6 +177,50 @@ static const float skybox_vertices[] = {
 
 int test_mode = 0;
 
+static float distance_sq(vec3_t a, vec3_t b)
+{
+    vec3_t d = v3_sub(a, b);
+    return v3_dot(d, d);
+}
+
+static void overdraw_query_begin(void)
+{
+    // gotovi rezultati iz proslih frejmova, bez cekanja na GPU
+    for (int b = 0; b < PROFILER_QUERY_BUFFERS; ++b)
+    {
+        if (!overdraw_query_pending[b])
+        {
+            continue;
+        }
+        GLuint available = 0;
+        glGetQueryObjectuiv(overdraw_queries[b], GL_QUERY_RESULT_AVAILABLE, &available);
+        if (available)
+        {
+            GLuint samples = 0;
+            glGetQueryObjectuiv(overdraw_queries[b], GL_QUERY_RESULT, &samples);
+            render_stats.overdraw = (float)samples / ((float)window_width * window_height);
+            overdraw_query_pending[b] = 0;
+        }
+    }
+
+    int buffer = render_frame % PROFILER_QUERY_BUFFERS;
+    overdraw_query_active = !overdraw_query_pending[buffer];
+    if (overdraw_query_active)
+    {
+        glBeginQuery(GL_SAMPLES_PASSED, overdraw_queries[buffer]);
+    }
+}
+
+static void overdraw_query_end(void)
+{
+    if (overdraw_query_active)
+    {
+        glEndQuery(GL_SAMPLES_PASSED);
+        overdraw_query_pending[render_frame % PROFILER_QUERY_BUFFERS] = 1;
+        overdraw_query_active = 0;
+    }
+}
+
 static mat4_t skybox_view_without_translation(mat4_t view)
 {
     view.m30 = 0.0f;
@@ -98,76 +235,194 @@ void main_state_init(GLFWwindow *window, void *args, int width, int height)
     window_width = width;
     window_height = height;
 
+    ThreadPool *pool = thread_pool_shared();
+    ThreadPoolGroup tree_group = { 0 };
+    memset(&tree_mesh_group, 0, sizeof(tree_mesh_group));
+
+    int phase = profiler_phase_begin("texture requests");
+    texture_stream_init(&texture_stream);
+    const char *material_paths[TERRAIN_MAX_MATERIALS];
+    for (int i = 0; i < terrain_material_count; ++i)
+    {
+        material_paths[i] = terrain_materials[i].path;
+    }
+    material_texture = texture_stream_request_array(&texture_stream, material_paths, terrain_material_count);
+    skybox_texture = texture_stream_request_cubemap(&texture_stream, skybox_faces);
+    textures_pending = 1;
+    profiler_phase_end(phase);
+
+    thread_pool_submit(pool, &tree_mesh_group, tree_mesh_job, &tree_system);
+
+    world_seed = DEFAULT_WORLD_SEED;
+    const char *seed_env = getenv("TERRAIN_SEED");
+    if (seed_env)
+    {
+        world_seed = (uint32_t)strtoul(seed_env, NULL, 10);
+    }
+
+    // TERRAIN_SIZE=<n> za vece svetove (npr. 8192 uz TERRAIN_CDLOD=1)
+    int terrain_size = TERRAIN_DEFAULT_SIZE;
+    const char *size_env = getenv("TERRAIN_SIZE");
+    if (size_env && atoi(size_env) > PATCH_SIZE)
+    {
+        terrain_size = atoi(size_env);
+    }
+
     // Initialize terrain
-    terrain_init(&terrain, PATCH_SIZE * 40);
+    phase = profiler_phase_begin("terrain heightmap");
+    terrain_init(&terrain, terrain_size, world_seed);
+    profiler_phase_end(phase);
+    // TERRAIN_VERTEX_FORMAT=full vraca stare vertexe od 32 bajta,
+    // heightmap crta iz teksture bez vertex buffera
+    const char *format_env = getenv("TERRAIN_VERTEX_FORMAT");
+    terrain.vertex_format = TERRAIN_VERTEX_COMPACT;
+    if (format_env && strcmp(format_env, "full") == 0)
+    {
+        terrain.vertex_format = TERRAIN_VERTEX_FULL;
+    }
+    else if (format_env && strcmp(format_env, "heightmap") == 0)
+    {
+        terrain.vertex_format = TERRAIN_VERTEX_HEIGHTMAP;
+    }
+    if (getenv("TERRAIN_CDLOD"))
+    {
+        // cvorovi quadtree-a crtaju isti grid razlicitim korakom, pa im treba tekstura
+        use_quadtree = 1;
+        terrain.vertex_format = TERRAIN_VERTEX_HEIGHTMAP;
+    }
+    phase = profiler_phase_begin("terrain vertices");
     terrain_generate_vertices(&terrain, 1.0f, 50.0f);
+    profiler_phase_end(phase);
+    phase = profiler_phase_begin("terrain normals");
     terrain_calculate_normals(&terrain);
+    profiler_phase_end(phase);
+    phase = profiler_phase_begin("terrain splat");
+    terrain_splat_init(&splat_map, &terrain, terrain_materials, terrain_material_count);
+    profiler_phase_end(phase);
+    // drvece trazi travnate vertekse, teren je sad gotov
+    thread_pool_submit(pool, &tree_group, tree_place_job, &tree_system);
+    patch_lods = malloc(terrain.patch_count * sizeof(int));
+
+    // TERRAIN_LOD_TOLERANCE=<px> koliko piksela greske LOD sme da napravi
+    const char *tolerance_env = getenv("TERRAIN_LOD_TOLERANCE");
+    lod_pixel_tolerance = tolerance_env ? strtof(tolerance_env, NULL) : TERRAIN_LOD_PIXEL_TOLERANCE;
+    if (lod_pixel_tolerance <= 0.0f)
+    {
+        lod_pixel_tolerance = TERRAIN_LOD_PIXEL_TOLERANCE;
+    }
     
     float aspect_ratio = (float)width / (float)height;
     camera_init(&camera, aspect_ratio);
 
+    phase = profiler_phase_begin("terrain upload");
     glGenVertexArrays(1, &vao);
     glGenBuffers(1, &vbo);
 
     glBindVertexArray(vao);
 
-    // upload vertexa u vbo
-    glBindBuffer(GL_ARRAY_BUFFER, vbo);
-    glBufferData(
-        GL_ARRAY_BUFFER,
-        terrain.vertex_count * sizeof(Vertex),
-        terrain.vertices,
-        GL_STATIC_DRAW
-    );
-
-    // koordinate
-    glEnableVertexAttribArray(0);
-    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)0);
-    // teksure
-    glEnableVertexAttribArray(1);
-    glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)(3 * sizeof(float)));
-    glEnableVertexAttribArray(2);
-    glVertexAttribPointer(2, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)(5 * sizeof(float)));
-
-    // patchovi za svaki lod level
-    for (int patch_idx = 0; patch_idx < terrain.patch_count; ++patch_idx) {
-        TerrainPatch *patch = &terrain.patches[patch_idx];
-        glGenBuffers(LOD_COUNT, patch->ebo);
-
-        for (int lod = 0; lod < LOD_COUNT; ++lod) {
-            int index_count = 0;
-            unsigned int *indices = terrain_build_patch_indices(&terrain, patch, g_lod_steps[lod], &index_count);
-            if (!indices || index_count == 0) {
-                continue;
-            }
-
-            glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, patch->ebo[lod]);
-            glBufferData(
-                GL_ELEMENT_ARRAY_BUFFER,
-                (GLsizeiptr)(index_count * sizeof(unsigned int)),
-                indices,
-                GL_STATIC_DRAW
-            );
-            patch->index_counts[lod] = index_count;
-            free(indices);
+    if (terrain.vertex_format == TERRAIN_VERTEX_HEIGHTMAP)
+    {
+        // VAO bez atributa: svi patchovi dele isti ravan grid (index buffer + gl_VertexID),
+        // a visina se cita iz teksture
+        heightmap_texture = terrain_heightmap_texture_create(&terrain);
+        if (use_quadtree)
+        {
+            terrain_quadtree_build(&quadtree, &terrain, 3.0f * PATCH_SIZE * terrain.spacing);
         }
     }
+    else
+    {
+        // upload vertexa u vbo
+        glBindBuffer(GL_ARRAY_BUFFER, vbo);
+        glBufferData(
+            GL_ARRAY_BUFFER,
+            terrain.vertex_count * terrain_vertex_stride(terrain.vertex_format),
+            terrain_vertex_data(&terrain),
+            GL_STATIC_DRAW
+        );
+    }
+
+    if (terrain.vertex_format == TERRAIN_VERTEX_COMPACT)
+    {
+        // visina (unorm16) i oktaedarska normala (snorm8), pozicija i uv iz gl_VertexID
+        glEnableVertexAttribArray(3);
+        glVertexAttribPointer(3, 1, GL_UNSIGNED_SHORT, GL_TRUE, sizeof(TerrainCompactVertex), (void*)offsetof(TerrainCompactVertex, height));
+        glEnableVertexAttribArray(4);
+        glVertexAttribPointer(4, 2, GL_BYTE, GL_TRUE, sizeof(TerrainCompactVertex), (void*)offsetof(TerrainCompactVertex, normal));
+    }
+    else if (terrain.vertex_format == TERRAIN_VERTEX_FULL)
+    {
+        // koordinate
+        glEnableVertexAttribArray(0);
+        glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)0);
+        // teksure
+        glEnableVertexAttribArray(1);
+        glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)(3 * sizeof(float)));
+        glEnableVertexAttribArray(2);
+        glVertexAttribPointer(2, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)(5 * sizeof(float)));
+    }
+
+    // jedan index buffer za sve patchove, patch bira svoj blok preko base vertexa
+    terrain_lod_indices_create(&terrain_indices);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, terrain_indices.buffer);
 
     glBindVertexArray(0);
+    profiler_phase_end(phase);
+
+    int draw_capacity = terrain.patch_count > TERRAIN_QUADTREE_MAX_DRAWS ? terrain.patch_count : TERRAIN_QUADTREE_MAX_DRAWS;
+    terrain_draw_list_init(&terrain_draws, draw_capacity);
+    terrain_draw_list_init(&shadow_draws, draw_capacity);
+    profiler_init();
 
+    printf("Terrain indices: %d shared (%zu KB) for %d patches\n",
+           terrain_indices.total_count,
+           terrain_indices.total_count * sizeof(TerrainIndex) / 1024,
+           terrain.patch_count);
+
+    phase = profiler_phase_begin("shaders");
     shader_program = rafgl_program_create_from_name("terrain");
     
     u_MVP_location = glGetUniformLocation(shader_program, "u_MVP");
+    u_vertex_format_loc = glGetUniformLocation(shader_program, "u_vertex_format");
 
-    tex_sand  = texture_load("res/textures/sand.png");
-    tex_grass = texture_load("res/textures/grass.png");
-    tex_rock  = texture_load("res/textures/rock.png");
-    tex_snow  = texture_load("res/textures/snow.png");
-    
-    tex_sand_loc  = glGetUniformLocation(shader_program, "u_tex_sand");
-    tex_grass_loc = glGetUniformLocation(shader_program, "u_tex_grass");
-    tex_rock_loc  = glGetUniformLocation(shader_program, "u_tex_rock");
-    tex_snow_loc  = glGetUniformLocation(shader_program, "u_tex_snow");
+    // raspored grida za compact format se ne menja
+    glUseProgram(shader_program);
+    glUniform1i(glGetUniformLocation(shader_program, "u_patch_size"), PATCH_SIZE);
+    glUniform1i(glGetUniformLocation(shader_program, "u_patch_cols"), terrain.patch_cols);
+    glUniform1i(glGetUniformLocation(shader_program, "u_block_vertices"), PATCH_BLOCK_VERTICES);
+    glUniform1i(glGetUniformLocation(shader_program, "u_grid_size"), terrain.size);
+    glUniform1f(glGetUniformLocation(shader_program, "u_spacing"), terrain.spacing);
+    glUniform2f(glGetUniformLocation(shader_program, "u_height_range"), terrain.compact_height_min, terrain.compact_height_range);
+    glUniform1f(glGetUniformLocation(shader_program, "u_skirt_depth"), SKIRT_DEPTH);
+    u_heightmap_loc = glGetUniformLocation(shader_program, "u_heightmap");
+    u_camera_pos_loc = glGetUniformLocation(shader_program, "u_camera_pos");
+    glUniform1i(glGetUniformLocation(shader_program, "u_nodes"), 5);
+    glUniform1i(glGetUniformLocation(shader_program, "u_grid_max"), terrain.patch_cols * PATCH_SIZE);
+    if (use_quadtree)
+    {
+        glUniform2fv(glGetUniformLocation(shader_program, "u_morph_ranges"), quadtree.levels, &quadtree.morph_ranges[0][0]);
+    }
+
+    // materijali se ne menjaju, po frejmu ostaje samo bind niza na jedinicu 0
+    float material_bands[TERRAIN_MAX_MATERIALS][4];
+    GLint material_slopes[TERRAIN_MAX_MATERIALS];
+    for (int i = 0; i < terrain_material_count; ++i)
+    {
+        memcpy(material_bands[i], terrain_materials[i].band, sizeof(material_bands[i]));
+        material_slopes[i] = terrain_materials[i].slope;
+    }
+    glUniform1i(glGetUniformLocation(shader_program, "u_materials"), 0);
+    glUniform1i(glGetUniformLocation(shader_program, "u_material_count"), terrain_material_count);
+    glUniform4fv(glGetUniformLocation(shader_program, "u_material_bands"), terrain_material_count, &material_bands[0][0]);
+    glUniform1iv(glGetUniformLocation(shader_program, "u_material_slope"), terrain_material_count, material_slopes);
+    glUniform1i(glGetUniformLocation(shader_program, "u_splat"), 6);
+    glUniform1i(glGetUniformLocation(shader_program, "u_splat_layers"), splat_map.layers);
+    u_use_splat_loc = glGetUniformLocation(shader_program, "u_use_splat");
+    u_depth_only_loc = glGetUniformLocation(shader_program, "u_depth_only");
+    u_overdraw_loc = glGetUniformLocation(shader_program, "u_overdraw");
+    shadow_map_get_uniforms(shader_program, &terrain_shadow_uniforms);
+    terrain_splat_upload(&splat_map);
+    glUseProgram(0);
     
     u_light_dir_loc     = glGetUniformLocation(shader_program, "u_light_dir");
     u_light_color_loc   = glGetUniformLocation(shader_program, "u_light_color");
@@ -191,29 +446,45 @@ void main_state_init(GLFWwindow *window, void *args, int width, int height)
     GLint skybox_sampler_loc = glGetUniformLocation(skybox_program, "u_skybox");
     glUniform1i(skybox_sampler_loc, 0);
     glUseProgram(0);
-
-    const char *skybox_faces[6] = {
-        "res/textures/skybox/right.png",
-        "res/textures/skybox/left.png",
-        "res/textures/skybox/top.png",
-        "res/textures/skybox/bottom.png",
-        "res/textures/skybox/front.png",
-        "res/textures/skybox/back.png"
-    };
-
-    skybox_texture = texture_load_cubemap(skybox_faces, 6);
-    if(!skybox_texture)
-    {
-        printf("Skybox cubemap failed to load. Check texture paths.\n");
-    }
+    profiler_phase_end(phase);
 
     glEnable(GL_DEPTH_TEST);
 
-    tree_system_init(&tree_system, &terrain);
+    phase = profiler_phase_begin("tree upload");
+    thread_pool_wait(pool, &tree_group);
+    tree_system_upload(&tree_system);
+    profiler_phase_end(phase);
 
     float terrain_extent = (terrain.size - 1) * terrain.spacing;
     float water_level = -10.0f;
     water_init(&water, terrain_extent, water_level);
+
+    terrain_stream_init(&terrain_stream, world_seed, terrain.spacing, terrain.height_scale);
+    if (getenv("TERRAIN_STREAMING"))
+    {
+        streaming_world = 1;
+    }
+    depth_prepass = getenv("TERRAIN_DEPTH_PREPASS") != NULL;
+    overdraw_view = getenv("TERRAIN_OVERDRAW") != NULL;
+    glGenQueries(PROFILER_QUERY_BUFFERS, overdraw_queries);
+
+    int shadow_cascades = SHADOW_DEFAULT_CASCADES;
+    const char *cascades_env = getenv("TERRAIN_SHADOW_CASCADES");
+    if (cascades_env)
+    {
+        shadow_cascades = atoi(cascades_env);
+    }
+    int shadow_resolution = SHADOW_DEFAULT_RESOLUTION;
+    const char *resolution_env = getenv("TERRAIN_SHADOW_RESOLUTION");
+    if (resolution_env && atoi(resolution_env) >= 64)
+    {
+        shadow_resolution = atoi(resolution_env);
+    }
+    shadow_map_init(&shadow_map, shadow_cascades, shadow_resolution);
+    tree_system.shadow = &shadow_map;
+
+    profiler_phase_report();
+    first_frame_pending = 1;
 }
 
 void main_state_update(GLFWwindow *window, float delta_time, rafgl_game_data_t *game_data, void *args)
@@ -226,71 +497,200 @@ void main_state_update(GLFWwindow *window, float delta_time, rafgl_game_data_t *
     {
         test_mode = !test_mode;
     }
+    if (game_data->keys_pressed[RAFGL_KEY_G])
+    {
+        streaming_world = !streaming_world;
+        water_set_center(&water, 0.0f, 0.0f);
+        printf("World mode: %s\n", streaming_world ? "streaming chunks" : "fixed terrain");
+    }
+    if (game_data->keys_pressed[RAFGL_KEY_Z])
+    {
+        depth_prepass = !depth_prepass;
+        printf("Depth pre-pass: %s\n", depth_prepass ? "on" : "off");
+    }
+    if (game_data->keys_pressed[RAFGL_KEY_V])
+    {
+        overdraw_view = !overdraw_view;
+        printf("Overdraw view: %s\n", overdraw_view ? "on" : "off");
+    }
+    if (game_data->keys_pressed[RAFGL_KEY_P])
+    {
+        profiler_set_overlay(!profiler_overlay_visible());
+    }
+    if (game_data->keys_pressed[RAFGL_KEY_O])
+    {
+        if (profiler_dump_csv("logs/profile.csv") == 0)
+        {
+            printf("Profile written to logs/profile.csv\n");
+        }
+    }
+    if (game_data->keys_pressed[RAFGL_KEY_C])
+    {
+        printf("Culling: terrain %d drawn / %d culled (%d triangles, %d draw calls), trees %d / %d, water %d / %d, overdraw %.2fx, shadow draw calls %d\n",
+               render_stats.patches.drawn, render_stats.patches.culled, render_stats.terrain_triangles,
+               render_stats.terrain_draw_calls,
+               render_stats.trees.drawn, render_stats.trees.culled,
+               render_stats.water.drawn, render_stats.water.culled, render_stats.overdraw,
+               render_stats.shadow_draw_calls);
+    }
     
+    profiler_begin(PROFILE_UPDATE);
+    texture_stream_update(&texture_stream);
+    if (textures_pending && texture_stream.pending == 0)
+    {
+        printf("Textures resident %.1f ms after init start\n", profiler_phase_elapsed());
+        textures_pending = 0;
+    }
     camera_update(&camera, delta_time, game_data);
+
+    if (streaming_world)
+    {
+        vec3_t cam_pos = camera_get_position(&camera);
+        terrain_stream_update(&terrain_stream, cam_pos);
+        water_set_center(&water, cam_pos.x, cam_pos.z);
+    }
+    profiler_end(PROFILE_UPDATE);
 }
 
-void main_state_render(GLFWwindow *window, void *args)
+// vidljivi patchovi (ili quadtree cvorovi) za zadati frustum; LOD je uvek iz pogleda kamere,
+// pa senke i glavni pass crtaju istu geometriju
+static void collect_terrain_draws(TerrainDrawList *list, vec3_t cam_pos, const Frustum *frustum,
+                                  CullCounter *cull, int *triangles)
 {
-    glClearColor(0.1f, 0.1f, 0.15f, 1.0f);
-    glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+    cull_counter_reset(cull);
+    *triangles = 0;
+    terrain_draw_list_reset(list);
 
-    
-    if (test_mode)
+    if (use_quadtree)
     {
-        glPolygonMode(GL_FRONT_AND_BACK, GL_LINE);
+        // broj crtanja zavisi od pogleda, ne od velicine sveta
+        terrain_quadtree_select(&quadtree, &terrain, cam_pos, frustum);
+        *cull = quadtree.cull;
+
+        float offset = (terrain.size - 1) * terrain.spacing / 2.0f;
+        for (int i = 0; i < quadtree.draw_count; ++i) {
+            // base vertex bira texel u u_nodes (i u multi-draw-u), indeksi su isti kao za patch,
+            // pa sortiranje komandi ne menja koji cvor se crta
+            const TerrainQuadDraw *draw = &quadtree.draws[i];
+            int lod = terrain_quadtree_draw_lod(draw);
+            float half = draw->cell_size * PATCH_SIZE * 0.5f;
+            vec3_t center = vec3((draw->col + half) * terrain.spacing - offset, cam_pos.y,
+                                 (draw->row + half) * terrain.spacing - offset);
+            *triangles += terrain_indices.counts[lod][0] / 3;
+            terrain_draw_list_add(list, terrain_indices.counts[lod][0],
+                                  terrain_indices.offsets[lod][0], i * PATCH_BLOCK_VERTICES,
+                                  distance_sq(center, cam_pos));
+        }
+        return;
     }
-    else
+
+    for (int patch_idx = 0; patch_idx < terrain.patch_count; ++patch_idx) {
+        TerrainPatch *patch = &terrain.patches[patch_idx];
+        vec3_t bounds_min, bounds_max;
+        terrain_patch_bounds(&terrain, patch, &bounds_min, &bounds_max);
+        if (!frustum_test_aabb(frustum, bounds_min, bounds_max)) {
+            cull->culled++;
+            continue;
+        }
+        cull->drawn++;
+
+        int lod = patch_lods[patch_idx];
+        int edge_mask = terrain_patch_edge_mask(&terrain, patch_lods, patch_idx);
+        vec3_t center = v3_muls(v3_add(bounds_min, bounds_max), 0.5f);
+        *triangles += terrain_indices.counts[lod][edge_mask] / 3;
+        terrain_draw_list_add(list, terrain_indices.counts[lod][edge_mask],
+                              terrain_indices.offsets[lod][edge_mask], patch->base_vertex,
+                              distance_sq(center, cam_pos));
+    }
+}
+
+// crta teren iz vec izabranih patchova/chunkova; redraw ponovo koristi komande poslate u pre-passu
+static int draw_terrain(TerrainDrawList *list, vec3_t cam_pos, const Frustum *frustum, int redraw)
+{
+    if (streaming_world)
     {
-        glPolygonMode(GL_FRONT_AND_BACK, GL_FILL);
+        terrain_stream_render(&terrain_stream, cam_pos, frustum);
+        return terrain_stream.cull.drawn;
     }
 
-    // prvo crtamo skybox
-    glDepthFunc(GL_LEQUAL);
-    glDepthMask(GL_FALSE);
-    glUseProgram(skybox_program);
+    glBindVertexArray(vao);
+    int draw_calls = redraw ? terrain_draw_list_redraw(list, TERRAIN_INDEX_GL_TYPE)
+                            : terrain_draw_list_submit(list, TERRAIN_INDEX_GL_TYPE, sizeof(TerrainIndex));
+    glBindVertexArray(0);
+    return draw_calls;
+}
 
-    mat4_t skybox_view = skybox_view_without_translation(camera.view);
-    glUniformMatrix4fv(skybox_view_loc, 1, GL_FALSE, &skybox_view.m[0][0]);
-    glUniformMatrix4fv(skybox_proj_loc, 1, GL_FALSE, &camera.projection.m[0][0]);
+// dubina terena i drveca iz pogleda svetla, jedan sloj po kaskadi; vraca broj draw poziva
+static int render_shadows(vec3_t cam_pos, vec3_t light_dir, vec3_t light_color, vec3_t ambient_color)
+{
+    int draw_calls = 0;
+    shadow_map_update(&shadow_map, &camera, light_dir);
+    shadow_map_begin(&shadow_map);
 
-    glBindVertexArray(skybox_vao);
+    // niz u koji se crta ne sme istovremeno da bude vezan za citanje
+    glActiveTexture(GL_TEXTURE0 + SHADOW_TEXTURE_UNIT);
+    glBindTexture(GL_TEXTURE_2D_ARRAY, 0);
     glActiveTexture(GL_TEXTURE0);
-    glBindTexture(GL_TEXTURE_CUBE_MAP, skybox_texture);
-    glDrawArrays(GL_TRIANGLES, 0, 36);
-    glBindVertexArray(0);
+    tree_system.shadow = NULL;
 
-    glUseProgram(0);
-    glDepthMask(GL_TRUE);
-    glDepthFunc(GL_LESS);
+    for (int i = 0; i < shadow_map.cascade_count; ++i)
+    {
+        const ShadowCascade *cascade = &shadow_map.cascades[i];
+        profiler_begin(PROFILE_SHADOW0 + i);
+        shadow_map_begin_cascade(&shadow_map, i);
+
+        glUseProgram(shader_program);
+        glUniform1i(u_depth_only_loc, 1);
+        glUniformMatrix4fv(u_MVP_location, 1, GL_FALSE, &cascade->view_projection.m[0][0]);
+        if (!streaming_world)
+        {
+            CullCounter cull;
+            int triangles;
+            collect_terrain_draws(&shadow_draws, cam_pos, &cascade->frustum, &cull, &triangles);
+        }
+        draw_calls += draw_terrain(&shadow_draws, cam_pos, &cascade->frustum, 0);
+        glUniform1i(u_depth_only_loc, 0);
+        glUseProgram(0);
+
+        if (!streaming_world)
+        {
+            tree_system.depth_only = 1;
+            tree_system_render(&tree_system, TREE_VIEW_SHADOW(i), cascade->view_projection, &cascade->frustum, light_dir, light_color, ambient_color);
+            tree_system.depth_only = 0;
+            draw_calls += tree_system.cull.drawn > 0;
+        }
+        profiler_end(PROFILE_SHADOW0 + i);
+    }
 
-    glUseProgram(shader_program);
+    shadow_map_end(&shadow_map);
+    tree_system.shadow = &shadow_map;
+    return draw_calls;
+}
 
-    if (test_mode)
+void main_state_render(GLFWwindow *window, void *args)
+{
+    // overdraw se sabira od crne
+    if (overdraw_view)
     {
-        glPolygonMode(GL_FRONT_AND_BACK, GL_LINE);
+        glClearColor(0.0f, 0.0f, 0.0f, 1.0f);
     }
     else
     {
-        glPolygonMode(GL_FRONT_AND_BACK, GL_FILL);
+        glClearColor(0.1f, 0.1f, 0.15f, 1.0f);
     }
+    glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
-    // dodela tekstura
+    // uniformi terena su isti za senke i za glavni pass
+    glUseProgram(shader_program);
+
+    // dodela tekstura: svi materijali su jedan niz
+    glActiveTexture(GL_TEXTURE0);
+    glBindTexture(GL_TEXTURE_2D_ARRAY, texture_stream_get(&texture_stream, material_texture));
+
+    glActiveTexture(GL_TEXTURE4);
+    glBindTexture(GL_TEXTURE_2D, heightmap_texture);
+    glUniform1i(u_heightmap_loc, 4);
     glActiveTexture(GL_TEXTURE0);
-    glBindTexture(GL_TEXTURE_2D, tex_sand);
-    glUniform1i(tex_sand_loc, 0);
-    
-    glActiveTexture(GL_TEXTURE1);
-    glBindTexture(GL_TEXTURE_2D, tex_grass);
-    glUniform1i(tex_grass_loc, 1);
-    
-    glActiveTexture(GL_TEXTURE2);
-    glBindTexture(GL_TEXTURE_2D, tex_rock);
-    glUniform1i(tex_rock_loc, 2);
-    
-    glActiveTexture(GL_TEXTURE3);
-    glBindTexture(GL_TEXTURE_2D, tex_snow);
-    glUniform1i(tex_snow_loc, 3);
     
     // dodavanje boje
     vec3_t light_dir = v3_norm(vec3(0.5f, 1.0f, 0.3f));
@@ -299,48 +699,196 @@ void main_state_render(GLFWwindow *window, void *args)
     glUniform3f(u_light_dir_loc, light_dir.x, light_dir.y, light_dir.z);
     glUniform3f(u_light_color_loc, light_color.x, light_color.y, light_color.z);
     glUniform3f(u_ambient_color_loc, ambient_color.x, ambient_color.y, ambient_color.z);
+    glUniform1i(u_overdraw_loc, overdraw_view);
+    tree_system.overdraw = overdraw_view;
 
-    // vp u shader
     mat4_t view_projection = camera_get_mvp(&camera);
-    glUniformMatrix4fv(u_MVP_location, 1, GL_FALSE, &view_projection.m[0][0]);
+
+    // isti frustum za sve sisteme u ovom frejmu
+    Frustum frustum;
+    frustum_from_matrix(&frustum, view_projection);
 
     vec3_t cam_pos = camera_get_position(&camera);
-    float offset = (terrain.size - 1) * terrain.spacing / 2.0f;
 
-    glBindVertexArray(vao);
-    // racunanje lod
-    for (int patch_idx = 0; patch_idx < terrain.patch_count; ++patch_idx) {
-        TerrainPatch *patch = &terrain.patches[patch_idx];
-        float center_x = (patch->origin.x + PATCH_SIZE * 0.5f) * terrain.spacing - offset;
-        float center_z = (patch->origin.y + PATCH_SIZE * 0.5f) * terrain.spacing - offset;
-        float dx = cam_pos.x - center_x;
-        float dz = cam_pos.z - center_z;
-        float distance = sqrtf(dx * dx + dz * dz);
-
-        int lod = 0;
-        if (distance > 120.0f) {
-            lod = 2;
-        } else if (distance > 60.0f) {
-            lod = 1;
+    if (streaming_world)
+    {
+        // chunkovi su uvek u punom formatu i nemaju splat mapu
+        glUniform1i(u_vertex_format_loc, TERRAIN_VERTEX_FULL);
+        glUniform1i(u_use_splat_loc, 0);
+    }
+    else
+    {
+        // tezine materijala su pecene, fragment shader ih cita jednim fetchom
+        glUniform1i(u_use_splat_loc, splat_map.texture != 0);
+        glActiveTexture(GL_TEXTURE6);
+        glBindTexture(GL_TEXTURE_2D_ARRAY, splat_map.texture);
+        glActiveTexture(GL_TEXTURE0);
+
+        if (use_quadtree)
+        {
+            glUniform1i(u_vertex_format_loc, TERRAIN_QUADTREE_SHADER_MODE);
+            glUniform3f(u_camera_pos_loc, cam_pos.x, cam_pos.y, cam_pos.z);
+            glActiveTexture(GL_TEXTURE5);
+            glBindTexture(GL_TEXTURE_BUFFER, quadtree.draw_texture);
+            glActiveTexture(GL_TEXTURE0);
         }
-        if (lod >= patch->lod_levels) {
-            lod = patch->lod_levels - 1;
+        else
+        {
+            glUniform1i(u_vertex_format_loc, terrain.vertex_format);
+
+            // lod za sve patchove odjednom da bi ivice znale LOD suseda
+            float lod_scale = window_height * 0.5f * camera.projection.m11;
+            terrain_select_lods(&terrain, cam_pos, lod_scale, lod_pixel_tolerance, patch_lods);
         }
+    }
 
-        if (patch->index_counts[lod] <= 0) {
-            continue;
+    render_stats.shadow_draw_calls = 0;
+    if (shadow_map.cascade_count > 0 && !overdraw_view)
+    {
+        render_stats.shadow_draw_calls = render_shadows(cam_pos, light_dir, light_color, ambient_color);
+    }
+
+    if (test_mode)
+    {
+        glPolygonMode(GL_FRONT_AND_BACK, GL_LINE);
+    }
+    else
+    {
+        glPolygonMode(GL_FRONT_AND_BACK, GL_FILL);
+    }
+
+    // izbor patchova ide u pre-pass kad postoji, oba passa crtaju isti skup
+    profiler_begin(depth_prepass ? PROFILE_PREPASS : PROFILE_TERRAIN);
+    glUseProgram(shader_program);
+
+    // vp u shader
+    glUniformMatrix4fv(u_MVP_location, 1, GL_FALSE, &view_projection.m[0][0]);
+    shadow_map_bind(&shadow_map, &terrain_shadow_uniforms, SHADOW_TEXTURE_UNIT);
+
+    if (!streaming_world)
+    {
+        collect_terrain_draws(&terrain_draws, cam_pos, &frustum, &render_stats.patches, &render_stats.terrain_triangles);
+        terrain_draw_list_sort(&terrain_draws);
+    }
+
+    int prepass_draw_calls = 0;
+    if (depth_prepass)
+    {
+        // samo depth, fragment shader terena odmah izlazi
+        glColorMask(GL_FALSE, GL_FALSE, GL_FALSE, GL_FALSE);
+        glUniform1i(u_depth_only_loc, 1);
+        prepass_draw_calls += draw_terrain(&terrain_draws, cam_pos, &frustum, 0);
+        glUniform1i(u_depth_only_loc, 0);
+        glUseProgram(0);
+        if (!streaming_world)
+        {
+            tree_system.depth_only = 1;
+            tree_system_render(&tree_system, TREE_VIEW_CAMERA, view_projection, &frustum, light_dir, light_color, ambient_color);
+            tree_system.depth_only = 0;
+            prepass_draw_calls += tree_system.cull.drawn > 0;
         }
+        glColorMask(GL_TRUE, GL_TRUE, GL_TRUE, GL_TRUE);
 
-        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, patch->ebo[lod]);
-        glDrawElements(GL_TRIANGLES, patch->index_counts[lod], GL_UNSIGNED_INT, 0);
+        // depth je vec konacan, color pass sencni samo najblizi fragment
+        glDepthMask(GL_FALSE);
+        glDepthFunc(GL_LEQUAL);
+        profiler_end(PROFILE_PREPASS);
+
+        profiler_begin(PROFILE_TERRAIN);
+        glUseProgram(shader_program);
     }
 
-    glBindVertexArray(0);
+    overdraw_query_begin();
+    if (overdraw_view)
+    {
+        glEnable(GL_BLEND);
+        glBlendFunc(GL_ONE, GL_ONE);
+    }
+
+    render_stats.terrain_draw_calls = draw_terrain(&terrain_draws, cam_pos, &frustum, depth_prepass && !streaming_world);
+    if (streaming_world)
+    {
+        render_stats.patches = terrain_stream.cull;
+        render_stats.terrain_triangles = terrain_stream.triangles;
+    }
     glUseProgram(0);
+    profiler_end(PROFILE_TERRAIN);
+
+    // drvece je postavljeno na fiksni teren
+    profiler_begin(PROFILE_TREES);
+    cull_counter_reset(&render_stats.trees);
+    if (!streaming_world)
+    {
+        tree_system_render(&tree_system, TREE_VIEW_CAMERA, view_projection, &frustum, light_dir, light_color, ambient_color);
+        render_stats.trees = tree_system.cull;
+    }
+    profiler_end(PROFILE_TREES);
+
+    if (overdraw_view)
+    {
+        glDisable(GL_BLEND);
+    }
+    overdraw_query_end();
+    glDepthMask(GL_TRUE);
+    glDepthFunc(GL_LESS);
+
+    // skybox i voda ne ulaze u prikaz overdrawa
+    cull_counter_reset(&render_stats.water);
+    if (!overdraw_view)
+    {
+        // skybox posle neprovidnih: vertex shader ga stavlja na daleku ravan (z = w),
+        // pa se sencni samo tamo gde teren i drvece nisu nista nacrtali
+        profiler_begin(PROFILE_SKYBOX);
+        glDepthFunc(GL_LEQUAL);
+        glDepthMask(GL_FALSE);
+        glUseProgram(skybox_program);
+
+        mat4_t skybox_view = skybox_view_without_translation(camera.view);
+        glUniformMatrix4fv(skybox_view_loc, 1, GL_FALSE, &skybox_view.m[0][0]);
+        glUniformMatrix4fv(skybox_proj_loc, 1, GL_FALSE, &camera.projection.m[0][0]);
+
+        glBindVertexArray(skybox_vao);
+        glActiveTexture(GL_TEXTURE0);
+        glBindTexture(GL_TEXTURE_CUBE_MAP, texture_stream_get(&texture_stream, skybox_texture));
+        glDrawArrays(GL_TRIANGLES, 0, 36);
+        glBindVertexArray(0);
+
+        glUseProgram(0);
+        glDepthMask(GL_TRUE);
+        glDepthFunc(GL_LESS);
+        profiler_end(PROFILE_SKYBOX);
+
+        // providna voda ide poslednja
+        profiler_begin(PROFILE_WATER);
+        water_render(&water, view_projection, &frustum, texture_stream_get(&texture_stream, skybox_texture), cam_pos);
+        render_stats.water = water.cull;
+        profiler_end(PROFILE_WATER);
+    }
+
+    // senke, pre-pass, teren, jedan instanced poziv za drvece, skybox i voda
+    render_stats.draw_calls = render_stats.shadow_draw_calls + prepass_draw_calls + render_stats.terrain_draw_calls + (render_stats.trees.drawn > 0) +
+                              (overdraw_view ? 0 : 1) + render_stats.water.drawn;
+    render_frame++;
 
-    water_render(&water, view_projection, skybox_texture, cam_pos);
+    profiler_frame_end();
+    profiler_draw_overlay(window_width, window_height);
 
-    tree_system_render(&tree_system, view_projection, light_dir, light_color, ambient_color);
+    if (first_frame_pending)
+    {
+        glFinish();
+        printf("First frame done %.1f ms after init start\n", profiler_phase_elapsed());
+        first_frame_pending = 0;
+    }
+}
+
+const RenderStats *main_state_render_stats(void)
+{
+    return &render_stats;
+}
+
+void main_state_set_camera_path(const CameraPath *path)
+{
+    camera_set_path(&camera, path);
 }
 
 void main_state_cleanup(GLFWwindow *window, void *args)
@@ -352,23 +900,32 @@ void main_state_cleanup(GLFWwindow *window, void *args)
     glDeleteVertexArrays(1, &skybox_vao);
     glDeleteBuffers(1, &skybox_vbo);
     glDeleteProgram(skybox_program);
-    glDeleteTextures(1, &skybox_texture);
+    glDeleteQueries(PROFILER_QUERY_BUFFERS, overdraw_queries);
     
-    glDeleteTextures(1, &tex_sand);
-    glDeleteTextures(1, &tex_grass);
-    glDeleteTextures(1, &tex_rock);
-    glDeleteTextures(1, &tex_snow);
+    texture_stream_cleanup(&texture_stream);
+    glDeleteTextures(1, &heightmap_texture);
+    terrain_splat_destroy(&splat_map);
 
     tree_system_cleanup(&tree_system);
     water_cleanup(&water);
-
-    for (int patch_idx = 0; patch_idx < terrain.patch_count; ++patch_idx) {
-        TerrainPatch *patch = &terrain.patches[patch_idx];
-        glDeleteBuffers(LOD_COUNT, patch->ebo);
+    terrain_stream_cleanup(&terrain_stream);
+
+    terrain_lod_indices_destroy(&terrain_indices);
+    terrain_draw_list_destroy(&terrain_draws);
+    terrain_draw_list_destroy(&shadow_draws);
+    shadow_map_cleanup(&shadow_map);
+    profiler_cleanup();
+    if (use_quadtree)
+    {
+        terrain_quadtree_destroy(&quadtree);
     }
 
     free(terrain.heightmap);
     free(terrain.vertices);
+    free(terrain.compact_vertices);
     free(terrain.patches);
+    free(patch_lods);
+
+    thread_pool_shared_shutdown();
 
 }
@@ -1,13 +1,32 @@
 #include <noise.h>
 #include <stdio.h>
 
-static int perm[TABLE_SIZE * 2];
+#if defined(__GNUC__) && (defined(__x86_64__) || (defined(__i386__) && defined(__SSE2__)))
+#define NOISE_X86_SIMD 1
+#include <immintrin.h>
+#define NOISE_TARGET_AVX2 __attribute__((target("avx2")))
+#else
+#define NOISE_X86_SIMD 0
+#endif
+
+#define FBM_MAX_OCTAVES 32
+
+static NoiseContext default_context;
 
 static float gradients[8][2] = {
     { 1, 0}, { -1, 0}, { 0, 1}, { 0,-1},
     { 1, 1}, { -1, 1}, { 1,-1}, {-1,-1}
 };
 
+// y deo Perlin suma je isti za ceo red, racuna se jednom po oktavi
+typedef struct {
+    int y0, y1;
+    float yf;
+    float v;
+} RowOctave;
+
+typedef void (*FbmRowKernel)(const int *perm, const float *xs, int n, const RowOctave *oct, int octaves, float *out);
+
 // 6t^5 - 15t^4 + 10t^3 
 static float fade(float t) {
     return t * t * t * (t * (t * 6 - 15) + 10);
@@ -23,7 +42,49 @@ static float grad(int hash, float x, float y) {
     return gradients[idx][0] * x + gradients[idx][1] * y;
 }
 
-void noise_init(void) {
+void noise_rng_seed(NoiseRng *rng, uint64_t seed, uint64_t stream) {
+    rng->state = 0;
+    rng->inc = (stream << 1u) | 1u;
+    noise_rng_next(rng);
+    rng->state += seed;
+    noise_rng_next(rng);
+}
+
+uint32_t noise_rng_next(NoiseRng *rng) {
+    uint64_t old_state = rng->state;
+    rng->state = old_state * 6364136223846793005ULL + rng->inc;
+    uint32_t xorshifted = (uint32_t)(((old_state >> 18u) ^ old_state) >> 27u);
+    uint32_t rot = (uint32_t)(old_state >> 59u);
+    return (xorshifted >> rot) | (xorshifted << ((-rot) & 31));
+}
+
+int noise_rng_below(NoiseRng *rng, int bound) {
+    if (bound <= 1) {
+        return 0;
+    }
+    // odbacivanje da ne bi bilo pristrasnosti kao kod rand() % n
+    uint32_t threshold = (uint32_t)(-(uint32_t)bound) % (uint32_t)bound;
+    for (;;) {
+        uint32_t r = noise_rng_next(rng);
+        if (r >= threshold) {
+            return (int)(r % (uint32_t)bound);
+        }
+    }
+}
+
+float noise_rng_float(NoiseRng *rng) {
+    return (noise_rng_next(rng) >> 8) * (1.0f / 16777216.0f);
+}
+
+float noise_rng_range(NoiseRng *rng, float min_value, float max_value) {
+    return min_value + noise_rng_float(rng) * (max_value - min_value);
+}
+
+void noise_context_init(NoiseContext *ctx, uint32_t seed) {
+    NoiseRng rng;
+    noise_rng_seed(&rng, seed, 0x6e6f697365ULL);
+    ctx->seed = seed;
+
     int temp[TABLE_SIZE];
     for (int i = 0; i < TABLE_SIZE; i++) {
         temp[i] = i;
@@ -31,20 +92,24 @@ void noise_init(void) {
     
     // shuffle
     for (int i = TABLE_SIZE - 1; i > 0; i--) {
-        int j = rand() % (i + 1);
+        int j = noise_rng_below(&rng, i + 1);
         int swap = temp[i];
         temp[i] = temp[j];
         temp[j] = swap;
     }
     
     for (int i = 0; i < TABLE_SIZE; i++) {
-        perm[i] = temp[i];
-        perm[i + TABLE_SIZE] = temp[i];
+        ctx->perm[i] = temp[i];
+        ctx->perm[i + TABLE_SIZE] = temp[i];
     }
-    
 }
 
-float perlin2d(float x, float y) {
+void noise_init(void) {
+    noise_context_init(&default_context, (uint32_t)rand());
+}
+
+float perlin2d_ctx(const NoiseContext *ctx, float x, float y) {
+    const int *perm = ctx->perm;
     int x0 = (int)floor(x) & PERM_MASK;
     int y0 = (int)floor(y) & PERM_MASK;
     int x1 = (x0 + 1) & PERM_MASK;
@@ -73,14 +138,237 @@ float perlin2d(float x, float y) {
     return lerp(lerp_top, lerp_bot, v);
 }
 
-float fbm(float x, float y, int octaves) {
+float fbm_ctx(const NoiseContext *ctx, float x, float y, int octaves) {
     float total = 0.0f;
     float freq = 1.0f;
     float amp = 1.0f;
     for(int i = 0; i < octaves; i++) {
-        total += perlin2d(x * freq, y * freq) * amp;
+        total += perlin2d_ctx(ctx, x * freq, y * freq) * amp;
+        freq *= 2.0f;
+        amp *= 0.5f;
+    }
+    return total;
+}
+
+float perlin2d(float x, float y) {
+    return perlin2d_ctx(&default_context, x, y);
+}
+
+float fbm(float x, float y, int octaves) {
+    return fbm_ctx(&default_context, x, y, octaves);
+}
+
+/* ---- fbm po redovima ---- */
+
+static RowOctave row_octave_make(float y) {
+    RowOctave r;
+    float fy = floorf(y);
+    r.y0 = (int)fy & PERM_MASK;
+    r.y1 = (r.y0 + 1) & PERM_MASK;
+    r.yf = y - fy;
+    r.v = fade(r.yf);
+    return r;
+}
+
+// isti redosled operacija kao perlin2d, samo sa vec izracunatim y delom
+static float perlin_row_point(const int *perm, float x, const RowOctave *r) {
+    float fx = floorf(x);
+    int x0 = (int)fx & PERM_MASK;
+    int x1 = (x0 + 1) & PERM_MASK;
+    float xf = x - fx;
+    float u = fade(xf);
+
+    int aa = perm[perm[x0] + r->y0];
+    int ab = perm[perm[x0] + r->y1];
+    int ba = perm[perm[x1] + r->y0];
+    int bb = perm[perm[x1] + r->y1];
+
+    float lerp_top = lerp(grad(aa, xf, r->yf), grad(ba, xf - 1, r->yf), u);
+    float lerp_bot = lerp(grad(ab, xf, r->yf - 1), grad(bb, xf - 1, r->yf - 1), u);
+
+    return lerp(lerp_top, lerp_bot, r->v);
+}
+
+static float fbm_row_point(const int *perm, float x, const RowOctave *oct, int octaves) {
+    float total = 0.0f;
+    float freq = 1.0f;
+    float amp = 1.0f;
+    for (int i = 0; i < octaves; i++) {
+        total += perlin_row_point(perm, x * freq, &oct[i]) * amp;
         freq *= 2.0f;
         amp *= 0.5f;
     }
     return total;
 }
+
+static void fbm_row_scalar(const int *perm, const float *xs, int n, const RowOctave *oct, int octaves, float *out) {
+    for (int i = 0; i < n; i++) {
+        out[i] = fbm_row_point(perm, xs[i], oct, octaves);
+    }
+}
+
+#if NOISE_X86_SIMD
+
+static const float grad_x[8] = { 1, -1, 0,  0, 1, -1,  1, -1 };
+static const float grad_y[8] = { 0,  0, 1, -1, 1,  1, -1, -1 };
+
+static inline __m128 sse_floor(__m128 x) {
+    // SSE2 nema floor, trunc pa ispravka za negativne
+    __m128 t = _mm_cvtepi32_ps(_mm_cvttps_epi32(x));
+    __m128 too_big = _mm_cmpgt_ps(t, x);
+    return _mm_sub_ps(t, _mm_and_ps(too_big, _mm_set1_ps(1.0f)));
+}
+
+static inline __m128 sse_fade(__m128 t) {
+    __m128 inner = _mm_add_ps(_mm_mul_ps(t, _mm_sub_ps(_mm_mul_ps(t, _mm_set1_ps(6.0f)), _mm_set1_ps(15.0f))), _mm_set1_ps(10.0f));
+    return _mm_mul_ps(_mm_mul_ps(_mm_mul_ps(t, t), t), inner);
+}
+
+static inline __m128 sse_lerp(__m128 a, __m128 b, __m128 t) {
+    return _mm_add_ps(a, _mm_mul_ps(t, _mm_sub_ps(b, a)));
+}
+
+static inline __m128 sse_grad(const int *hash, __m128 x, __m128 y) {
+    __m128 gx = _mm_setr_ps(grad_x[hash[0] & 7], grad_x[hash[1] & 7], grad_x[hash[2] & 7], grad_x[hash[3] & 7]);
+    __m128 gy = _mm_setr_ps(grad_y[hash[0] & 7], grad_y[hash[1] & 7], grad_y[hash[2] & 7], grad_y[hash[3] & 7]);
+    return _mm_add_ps(_mm_mul_ps(gx, x), _mm_mul_ps(gy, y));
+}
+
+static void fbm_row_sse2(const int *perm, const float *xs, int n, const RowOctave *oct, int octaves, float *out) {
+    const __m128 one = _mm_set1_ps(1.0f);
+    const __m128i mask = _mm_set1_epi32(PERM_MASK);
+    int i = 0;
+    for (; i + 4 <= n; i += 4) {
+        __m128 x_base = _mm_loadu_ps(xs + i);
+        __m128 total = _mm_setzero_ps();
+        float freq = 1.0f;
+        float amp = 1.0f;
+        for (int o = 0; o < octaves; o++) {
+            const RowOctave *r = &oct[o];
+            __m128 x = _mm_mul_ps(x_base, _mm_set1_ps(freq));
+            __m128 fx = sse_floor(x);
+            __m128i x0 = _mm_and_si128(_mm_cvttps_epi32(fx), mask);
+            __m128 xf = _mm_sub_ps(x, fx);
+            __m128 xf1 = _mm_sub_ps(xf, one);
+            __m128 u = sse_fade(xf);
+
+            int x0s[4], aa[4], ab[4], ba[4], bb[4];
+            _mm_storeu_si128((__m128i *)x0s, x0);
+            for (int k = 0; k < 4; k++) {
+                int p0 = perm[x0s[k]];
+                int p1 = perm[(x0s[k] + 1) & PERM_MASK];
+                aa[k] = perm[p0 + r->y0];
+                ab[k] = perm[p0 + r->y1];
+                ba[k] = perm[p1 + r->y0];
+                bb[k] = perm[p1 + r->y1];
+            }
+
+            __m128 yf = _mm_set1_ps(r->yf);
+            __m128 yf1 = _mm_set1_ps(r->yf - 1);
+            __m128 lerp_top = sse_lerp(sse_grad(aa, xf, yf), sse_grad(ba, xf1, yf), u);
+            __m128 lerp_bot = sse_lerp(sse_grad(ab, xf, yf1), sse_grad(bb, xf1, yf1), u);
+            __m128 value = sse_lerp(lerp_top, lerp_bot, _mm_set1_ps(r->v));
+
+            total = _mm_add_ps(total, _mm_mul_ps(value, _mm_set1_ps(amp)));
+            freq *= 2.0f;
+            amp *= 0.5f;
+        }
+        _mm_storeu_ps(out + i, total);
+    }
+    fbm_row_scalar(perm, xs + i, n - i, oct, octaves, out + i);
+}
+
+NOISE_TARGET_AVX2 static inline __m256 avx_fade(__m256 t) {
+    __m256 inner = _mm256_add_ps(_mm256_mul_ps(t, _mm256_sub_ps(_mm256_mul_ps(t, _mm256_set1_ps(6.0f)), _mm256_set1_ps(15.0f))), _mm256_set1_ps(10.0f));
+    return _mm256_mul_ps(_mm256_mul_ps(_mm256_mul_ps(t, t), t), inner);
+}
+
+NOISE_TARGET_AVX2 static inline __m256 avx_lerp(__m256 a, __m256 b, __m256 t) {
+    return _mm256_add_ps(a, _mm256_mul_ps(t, _mm256_sub_ps(b, a)));
+}
+
+// 8 gradijenata staje u jedan registar pa je lookup samo permutacija
+NOISE_TARGET_AVX2 static inline __m256 avx_grad(__m256i hash, __m256 x, __m256 y, __m256 gx_table, __m256 gy_table) {
+    __m256 gx = _mm256_permutevar8x32_ps(gx_table, hash);
+    __m256 gy = _mm256_permutevar8x32_ps(gy_table, hash);
+    return _mm256_add_ps(_mm256_mul_ps(gx, x), _mm256_mul_ps(gy, y));
+}
+
+NOISE_TARGET_AVX2 static void fbm_row_avx2(const int *perm, const float *xs, int n, const RowOctave *oct, int octaves, float *out) {
+    const __m256 one = _mm256_set1_ps(1.0f);
+    const __m256i mask = _mm256_set1_epi32(PERM_MASK);
+    const __m256i one_i = _mm256_set1_epi32(1);
+    const __m256 gx_table = _mm256_loadu_ps(grad_x);
+    const __m256 gy_table = _mm256_loadu_ps(grad_y);
+    int i = 0;
+    for (; i + 8 <= n; i += 8) {
+        __m256 x_base = _mm256_loadu_ps(xs + i);
+        __m256 total = _mm256_setzero_ps();
+        float freq = 1.0f;
+        float amp = 1.0f;
+        for (int o = 0; o < octaves; o++) {
+            const RowOctave *r = &oct[o];
+            __m256 x = _mm256_mul_ps(x_base, _mm256_set1_ps(freq));
+            __m256 fx = _mm256_floor_ps(x);
+            __m256i x0 = _mm256_and_si256(_mm256_cvttps_epi32(fx), mask);
+            __m256i x1 = _mm256_and_si256(_mm256_add_epi32(x0, one_i), mask);
+            __m256 xf = _mm256_sub_ps(x, fx);
+            __m256 xf1 = _mm256_sub_ps(xf, one);
+            __m256 u = avx_fade(xf);
+
+            __m256i p0 = _mm256_i32gather_epi32(perm, x0, 4);
+            __m256i p1 = _mm256_i32gather_epi32(perm, x1, 4);
+            __m256i y0 = _mm256_set1_epi32(r->y0);
+            __m256i y1 = _mm256_set1_epi32(r->y1);
+            // hash & 7 radi permutevar sam, gleda samo donja 3 bita
+            __m256i aa = _mm256_i32gather_epi32(perm, _mm256_add_epi32(p0, y0), 4);
+            __m256i ab = _mm256_i32gather_epi32(perm, _mm256_add_epi32(p0, y1), 4);
+            __m256i ba = _mm256_i32gather_epi32(perm, _mm256_add_epi32(p1, y0), 4);
+            __m256i bb = _mm256_i32gather_epi32(perm, _mm256_add_epi32(p1, y1), 4);
+
+            __m256 yf = _mm256_set1_ps(r->yf);
+            __m256 yf1 = _mm256_set1_ps(r->yf - 1);
+            __m256 lerp_top = avx_lerp(avx_grad(aa, xf, yf, gx_table, gy_table), avx_grad(ba, xf1, yf, gx_table, gy_table), u);
+            __m256 lerp_bot = avx_lerp(avx_grad(ab, xf, yf1, gx_table, gy_table), avx_grad(bb, xf1, yf1, gx_table, gy_table), u);
+            __m256 value = avx_lerp(lerp_top, lerp_bot, _mm256_set1_ps(r->v));
+
+            total = _mm256_add_ps(total, _mm256_mul_ps(value, _mm256_set1_ps(amp)));
+            freq *= 2.0f;
+            amp *= 0.5f;
+        }
+        _mm256_storeu_ps(out + i, total);
+    }
+    fbm_row_sse2(perm, xs + i, n - i, oct, octaves, out + i);
+}
+
+#endif // NOISE_X86_SIMD
+
+static FbmRowKernel select_row_kernel(void) {
+#if NOISE_X86_SIMD
+    if (__builtin_cpu_supports("avx2")) {
+        return fbm_row_avx2;
+    }
+    return fbm_row_sse2;
+#else
+    return fbm_row_scalar;
+#endif
+}
+
+void fbm_row_ctx(const NoiseContext *ctx, const float *xs, float y, int n, int octaves, float *out) {
+    if (octaves > FBM_MAX_OCTAVES) {
+        octaves = FBM_MAX_OCTAVES;
+    }
+
+    RowOctave oct[FBM_MAX_OCTAVES];
+    float freq = 1.0f;
+    for (int i = 0; i < octaves; i++) {
+        oct[i] = row_octave_make(y * freq);
+        freq *= 2.0f;
+    }
+
+    select_row_kernel()(ctx->perm, xs, n, oct, octaves, out);
+}
+
+void fbm_row(const float *xs, float y, int n, int octaves, float *out) {
+    fbm_row_ctx(&default_context, xs, y, n, octaves, out);
+}
@@ -0,0 +1,402 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+#include <pthread.h>
+#include <profiler.h>
+#include <rafgl.h>
+
+static const char *scope_names[PROFILE_SCOPE_COUNT] = {
+    "update", "shadow0", "shadow1", "shadow2", "shadow3", "prepass", "terrain", "trees", "skybox", "water"
+};
+// update ne salje nista GPU-u
+static const int scope_has_gpu[PROFILE_SCOPE_COUNT] = { 0, 1, 1, 1, 1, 1, 1, 1, 1, 1 };
+
+typedef struct {
+    float cpu_ms[PROFILER_HISTORY]; // < 0 znaci da nema uzorka
+    float gpu_ms[PROFILER_HISTORY];
+    double cpu_start;
+    GLuint queries[PROFILER_QUERY_BUFFERS];
+    long query_frame[PROFILER_QUERY_BUFFERS];
+    int query_pending[PROFILER_QUERY_BUFFERS];
+    int query_active;   // upit je otvoren u ovom frejmu
+} ProfilerScopeData;
+
+static struct {
+    int initialized;
+    long frame;
+    ProfilerScopeData scopes[PROFILE_SCOPE_COUNT];
+
+    int overlay_visible;
+    int overlay_text;   // rafgl fontovi postoje, bez njih draw_string cita neucitan sheet
+    long overlay_frame;
+    rafgl_raster_t overlay_raster;
+    rafgl_texture_t overlay_texture;
+} profiler;
+
+// ne brise ga profiler_init, faze pocinju pre njega
+static struct {
+    pthread_mutex_t mutex;
+    pthread_t main_thread;
+    double origin_ms;
+    ProfilePhase phases[PROFILER_MAX_PHASES];
+    int count;
+} startup = { .mutex = PTHREAD_MUTEX_INITIALIZER };
+
+static double now_ms(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000.0 + ts.tv_nsec / 1000000.0;
+}
+
+static void reset_slot(long frame)
+{
+    int slot = (int)(frame % PROFILER_HISTORY);
+    for (int i = 0; i < PROFILE_SCOPE_COUNT; ++i) {
+        profiler.scopes[i].cpu_ms[slot] = -1.0f;
+        profiler.scopes[i].gpu_ms[slot] = -1.0f;
+    }
+}
+
+void profiler_init(void)
+{
+    memset(&profiler, 0, sizeof(profiler));
+    for (int i = 0; i < PROFILE_SCOPE_COUNT; ++i) {
+        for (int f = 0; f < PROFILER_HISTORY; ++f) {
+            profiler.scopes[i].cpu_ms[f] = -1.0f;
+            profiler.scopes[i].gpu_ms[f] = -1.0f;
+        }
+        if (scope_has_gpu[i]) {
+            glGenQueries(PROFILER_QUERY_BUFFERS, profiler.scopes[i].queries);
+        }
+    }
+    profiler.overlay_frame = -PROFILER_OVERLAY_REFRESH;
+
+    FILE *font = fopen("res/fonts/chars-small.png", "rb");
+    if (font) {
+        profiler.overlay_text = 1;
+        fclose(font);
+    }
+    profiler.initialized = 1;
+}
+
+void profiler_begin(ProfileScope scope)
+{
+    ProfilerScopeData *data = &profiler.scopes[scope];
+    data->cpu_start = now_ms();
+    data->query_active = 0;
+    if (!profiler.initialized || !scope_has_gpu[scope]) {
+        return;
+    }
+
+    // ako rezultat od pre PROFILER_QUERY_BUFFERS frejmova jos nije stigao,
+    // ovaj frejm ostaje bez GPU uzorka umesto da se ceka
+    int buffer = (int)(profiler.frame % PROFILER_QUERY_BUFFERS);
+    if (data->query_pending[buffer]) {
+        return;
+    }
+    glBeginQuery(GL_TIME_ELAPSED, data->queries[buffer]);
+    data->query_frame[buffer] = profiler.frame;
+    data->query_active = 1;
+}
+
+void profiler_end(ProfileScope scope)
+{
+    ProfilerScopeData *data = &profiler.scopes[scope];
+    int slot = (int)(profiler.frame % PROFILER_HISTORY);
+    float elapsed = (float)(now_ms() - data->cpu_start);
+    data->cpu_ms[slot] = data->cpu_ms[slot] < 0.0f ? elapsed : data->cpu_ms[slot] + elapsed;
+
+    if (data->query_active) {
+        glEndQuery(GL_TIME_ELAPSED);
+        data->query_pending[profiler.frame % PROFILER_QUERY_BUFFERS] = 1;
+        data->query_active = 0;
+    }
+}
+
+void profiler_frame_end(void)
+{
+    if (!profiler.initialized) {
+        return;
+    }
+
+    for (int i = 0; i < PROFILE_SCOPE_COUNT; ++i) {
+        ProfilerScopeData *data = &profiler.scopes[i];
+        for (int b = 0; b < PROFILER_QUERY_BUFFERS; ++b) {
+            if (!data->query_pending[b]) {
+                continue;
+            }
+            GLuint available = 0;
+            glGetQueryObjectuiv(data->queries[b], GL_QUERY_RESULT_AVAILABLE, &available);
+            if (!available) {
+                continue;
+            }
+            GLuint64 ns = 0;
+            glGetQueryObjectui64v(data->queries[b], GL_QUERY_RESULT, &ns);
+            data->query_pending[b] = 0;
+            // uzorak ide u frejm u kom je upit poslat, ako je jos u istoriji
+            if (profiler.frame - data->query_frame[b] < PROFILER_HISTORY) {
+                data->gpu_ms[data->query_frame[b] % PROFILER_HISTORY] = (float)(ns / 1000000.0);
+            }
+        }
+    }
+
+    profiler.frame++;
+    reset_slot(profiler.frame);
+}
+
+static int compare_floats(const void *a, const void *b)
+{
+    float fa = *(const float *)a;
+    float fb = *(const float *)b;
+    return (fa > fb) - (fa < fb);
+}
+
+void profiler_stats(ProfileScope scope, int gpu, ProfileStats *out)
+{
+    const float *history = gpu ? profiler.scopes[scope].gpu_ms : profiler.scopes[scope].cpu_ms;
+    float samples[PROFILER_HISTORY];
+    int count = 0;
+    double sum = 0.0;
+    for (int i = 0; i < PROFILER_HISTORY; ++i) {
+        if (history[i] >= 0.0f) {
+            samples[count++] = history[i];
+            sum += history[i];
+        }
+    }
+
+    memset(out, 0, sizeof(*out));
+    out->samples = count;
+    if (count == 0) {
+        return;
+    }
+    qsort(samples, count, sizeof(float), compare_floats);
+    out->min_ms = samples[0];
+    out->avg_ms = (float)(sum / count);
+    out->p99_ms = samples[(int)ceilf(0.99f * count) - 1];
+}
+
+const char *profiler_scope_name(ProfileScope scope)
+{
+    return scope_names[scope];
+}
+
+void profiler_set_overlay(int visible)
+{
+    profiler.overlay_visible = visible;
+    profiler.overlay_frame = profiler.frame - PROFILER_OVERLAY_REFRESH;
+}
+
+int profiler_overlay_visible(void)
+{
+    return profiler.overlay_visible;
+}
+
+static void fill_rect(rafgl_raster_t *raster, int x0, int y0, int x1, int y1, uint32_t colour)
+{
+    if (x0 < 0) x0 = 0;
+    if (y0 < 0) y0 = 0;
+    if (x1 > raster->width) x1 = raster->width;
+    if (y1 > raster->height) y1 = raster->height;
+    for (int y = y0; y < y1; ++y) {
+        for (int x = x0; x < x1; ++x) {
+            raster->data[y * raster->width + x].rgba = colour;
+        }
+    }
+}
+
+static void overlay_redraw(rafgl_raster_t *raster)
+{
+    const int left = 8, top = 8, row_height = 16, bar_x = 300;
+    const float bar_px_per_ms = 20.0f;
+    const int panel_width = 440;
+    const int panel_height = (PROFILE_SCOPE_COUNT + 1) * row_height + 8;
+
+    memset(raster->data, 0, raster->width * raster->height * sizeof(rafgl_pixel_rgb_t));
+    fill_rect(raster, left - 4, top - 4, left + panel_width, top + panel_height, rafgl_RGBA(0, 0, 0, 170));
+    if (profiler.overlay_text) {
+        rafgl_raster_draw_string(raster, "scope    cpu min/avg/p99   gpu min/avg/p99 ms", left, top, rafgl_RGB(255, 255, 255), 0);
+    }
+
+    for (int i = 0; i < PROFILE_SCOPE_COUNT; ++i) {
+        ProfileStats cpu, gpu;
+        profiler_stats(i, 0, &cpu);
+        profiler_stats(i, 1, &gpu);
+
+        char line[128];
+        if (gpu.samples > 0) {
+            snprintf(line, sizeof(line), "%-8s %5.2f %5.2f %5.2f   %5.2f %5.2f %5.2f", scope_names[i],
+                     cpu.min_ms, cpu.avg_ms, cpu.p99_ms, gpu.min_ms, gpu.avg_ms, gpu.p99_ms);
+        } else {
+            snprintf(line, sizeof(line), "%-8s %5.2f %5.2f %5.2f       -", scope_names[i],
+                     cpu.min_ms, cpu.avg_ms, cpu.p99_ms);
+        }
+        int y = top + (i + 1) * row_height;
+        if (profiler.overlay_text) {
+            rafgl_raster_draw_string(raster, line, left, y, rafgl_RGB(255, 255, 255), 0);
+        }
+
+        // trake vide i bez fontova: cpu prosek gore, gpu prosek dole, crtica na p99
+        int cpu_width = (int)fminf(cpu.avg_ms * bar_px_per_ms, panel_width - bar_x);
+        int gpu_width = (int)fminf(gpu.avg_ms * bar_px_per_ms, panel_width - bar_x);
+        int cpu_p99 = (int)fminf(cpu.p99_ms * bar_px_per_ms, panel_width - bar_x - 2);
+        fill_rect(raster, left + bar_x, y + 2, left + bar_x + cpu_width, y + 7, rafgl_RGBA(90, 200, 255, 230));
+        fill_rect(raster, left + bar_x, y + 8, left + bar_x + gpu_width, y + 13, rafgl_RGBA(255, 170, 60, 230));
+        fill_rect(raster, left + bar_x + cpu_p99, y + 1, left + bar_x + cpu_p99 + 2, y + 14, rafgl_RGBA(255, 60, 60, 230));
+    }
+}
+
+void profiler_draw_overlay(int width, int height)
+{
+    if (!profiler.initialized || !profiler.overlay_visible) {
+        return;
+    }
+
+    if (profiler.overlay_raster.width != width || profiler.overlay_raster.height != height) {
+        if (profiler.overlay_raster.data) {
+            rafgl_raster_cleanup(&profiler.overlay_raster);
+            rafgl_texture_cleanup(&profiler.overlay_texture);
+        }
+        rafgl_raster_init(&profiler.overlay_raster, width, height);
+        rafgl_texture_init(&profiler.overlay_texture);
+        profiler.overlay_frame = profiler.frame - PROFILER_OVERLAY_REFRESH;
+    }
+
+    // tekst i upload samo povremeno, izmedju se crta ista tekstura
+    if (profiler.frame - profiler.overlay_frame >= PROFILER_OVERLAY_REFRESH) {
+        overlay_redraw(&profiler.overlay_raster);
+        rafgl_texture_load_from_raster(&profiler.overlay_texture, &profiler.overlay_raster);
+        profiler.overlay_frame = profiler.frame;
+    }
+
+    GLboolean depth_test = glIsEnabled(GL_DEPTH_TEST);
+    GLboolean blend = glIsEnabled(GL_BLEND);
+    glDisable(GL_DEPTH_TEST);
+    glEnable(GL_BLEND);
+    glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+    glPolygonMode(GL_FRONT_AND_BACK, GL_FILL);
+
+    rafgl_texture_show(&profiler.overlay_texture, 0);
+
+    if (depth_test) glEnable(GL_DEPTH_TEST);
+    if (!blend) glDisable(GL_BLEND);
+}
+
+int profiler_dump_csv(const char *path)
+{
+    FILE *file = fopen(path, "w");
+    if (!file) {
+        return -1;
+    }
+
+    fprintf(file, "frame,scope,cpu_ms,gpu_ms\n");
+    long first = profiler.frame - PROFILER_HISTORY + 1;
+    if (first < 0) {
+        first = 0;
+    }
+    // tekuci frejm jos nije zavrsen
+    for (long frame = first; frame < profiler.frame; ++frame) {
+        int slot = (int)(frame % PROFILER_HISTORY);
+        for (int i = 0; i < PROFILE_SCOPE_COUNT; ++i) {
+            float cpu = profiler.scopes[i].cpu_ms[slot];
+            float gpu = profiler.scopes[i].gpu_ms[slot];
+            if (cpu < 0.0f && gpu < 0.0f) {
+                continue;
+            }
+            fprintf(file, "%ld,%s,", frame, scope_names[i]);
+            if (cpu >= 0.0f) fprintf(file, "%.4f", cpu);
+            fprintf(file, ",");
+            if (gpu >= 0.0f) fprintf(file, "%.4f", gpu);
+            fprintf(file, "\n");
+        }
+    }
+
+    fclose(file);
+    return 0;
+}
+
+void profiler_cleanup(void)
+{
+    if (!profiler.initialized) {
+        return;
+    }
+    for (int i = 0; i < PROFILE_SCOPE_COUNT; ++i) {
+        if (scope_has_gpu[i]) {
+            glDeleteQueries(PROFILER_QUERY_BUFFERS, profiler.scopes[i].queries);
+        }
+    }
+    if (profiler.overlay_raster.data) {
+        rafgl_raster_cleanup(&profiler.overlay_raster);
+        rafgl_texture_cleanup(&profiler.overlay_texture);
+    }
+    profiler.initialized = 0;
+}
+
+int profiler_phase_begin(const char *name)
+{
+    double start = now_ms();
+    pthread_mutex_lock(&startup.mutex);
+    if (startup.count == 0) {
+        startup.main_thread = pthread_self();
+        startup.origin_ms = start;
+    }
+    int phase = -1;
+    if (startup.count < PROFILER_MAX_PHASES) {
+        phase = startup.count++;
+        ProfilePhase *entry = &startup.phases[phase];
+        entry->name = name;
+        entry->start_ms = start - startup.origin_ms;
+        entry->end_ms = -1.0;
+        entry->on_worker = !pthread_equal(pthread_self(), startup.main_thread);
+    }
+    pthread_mutex_unlock(&startup.mutex);
+    return phase;
+}
+
+void profiler_phase_end(int phase)
+{
+    double end = now_ms();
+    if (phase < 0) {
+        return;
+    }
+    pthread_mutex_lock(&startup.mutex);
+    startup.phases[phase].end_ms = end - startup.origin_ms;
+    pthread_mutex_unlock(&startup.mutex);
+}
+
+int profiler_phase_count(void)
+{
+    return startup.count;
+}
+
+const ProfilePhase *profiler_phase_get(int index)
+{
+    return &startup.phases[index];
+}
+
+double profiler_phase_elapsed(void)
+{
+    return startup.count > 0 ? now_ms() - startup.origin_ms : 0.0;
+}
+
+void profiler_phase_report(void)
+{
+    double sum = 0.0, longest = 0.0;
+    printf("Startup phases (ms from start):\n");
+    pthread_mutex_lock(&startup.mutex);
+    for (int i = 0; i < startup.count; ++i) {
+        const ProfilePhase *phase = &startup.phases[i];
+        double duration = phase->end_ms - phase->start_ms;
+        printf("  %-32s %8.1f -> %8.1f  %8.1f ms  %s\n", phase->name, phase->start_ms, phase->end_ms,
+               duration, phase->on_worker ? "worker" : "main");
+        sum += duration;
+        if (duration > longest) {
+            longest = duration;
+        }
+    }
+    pthread_mutex_unlock(&startup.mutex);
+    printf("  total %.1f ms wall, %.1f ms summed over phases, longest phase %.1f ms\n",
+           profiler_phase_elapsed(), sum, longest);
+}
@@ -0,0 +1,159 @@
+#include <shadow.h>
+#include <stdio.h>
+#include <math.h>
+#include <string.h>
+
+void shadow_map_init(ShadowMap *shadow, int cascade_count, int resolution)
+{
+    memset(shadow, 0, sizeof(*shadow));
+    if (cascade_count > SHADOW_MAX_CASCADES) {
+        cascade_count = SHADOW_MAX_CASCADES;
+    }
+    if (cascade_count <= 0) {
+        return;
+    }
+
+    GLint max_size = 0;
+    glGetIntegerv(GL_MAX_TEXTURE_SIZE, &max_size);
+    if (resolution > max_size) {
+        resolution = max_size;
+    }
+    shadow->cascade_count = cascade_count;
+    shadow->resolution = resolution;
+    shadow->framebuffer = rafgl_framebuffer_depth_create(resolution, resolution, cascade_count);
+    printf("Shadows: %d cascades, %dx%d each, up to %.0f units\n", cascade_count, resolution, resolution, SHADOW_DISTANCE);
+}
+
+// mesavina logaritamskih i ravnomernih podela (practical split scheme)
+static float split_distance(int index, int count, float near, float far)
+{
+    float t = (float)index / count;
+    float log_split = near * powf(far / near, t);
+    float uniform_split = near + (far - near) * t;
+    return SHADOW_SPLIT_LAMBDA * log_split + (1.0f - SHADOW_SPLIT_LAMBDA) * uniform_split;
+}
+
+static void update_cascade(ShadowCascade *cascade, const Camera *camera, mat4_t light_view, int resolution)
+{
+    // uglovi dela frustuma izmedju dve podele, tangensi iz projekcije kamere
+    float tan_x = 1.0f / camera->projection.m00;
+    float tan_y = 1.0f / camera->projection.m11;
+    vec3_t up = v3_cross(camera->right, camera->front);
+    vec3_t corners[8];
+    float distances[2] = { cascade->split_near, cascade->split_far };
+    for (int i = 0; i < 8; ++i) {
+        float d = distances[i >> 2];
+        float sx = (i & 1) ? 1.0f : -1.0f;
+        float sy = (i & 2) ? 1.0f : -1.0f;
+        corners[i] = v3_add(camera->position, v3_add(v3_muls(camera->front, d),
+                            v3_add(v3_muls(camera->right, sx * d * tan_x), v3_muls(up, sy * d * tan_y))));
+    }
+
+    // sfera oko uglova ne zavisi od okretanja kamere, pa velicina kaskade ostaje ista
+    vec3_t center = vec3(0.0f, 0.0f, 0.0f);
+    for (int i = 0; i < 8; ++i) {
+        center = v3_add(center, corners[i]);
+    }
+    center = v3_muls(center, 1.0f / 8.0f);
+    float radius = 0.0f;
+    for (int i = 0; i < 8; ++i) {
+        radius = fmaxf(radius, v3_length(v3_sub(corners[i], center)));
+    }
+    radius = ceilf(radius * 16.0f) / 16.0f;
+
+    // centar se pomera samo za cele texele, pa ivice senki ne trepere dok se kamera krece
+    float texel = 2.0f * radius / resolution;
+    vec3_t light_center = m4_mul_pos(light_view, center);
+    light_center.x = floorf(light_center.x / texel) * texel;
+    light_center.y = floorf(light_center.y / texel) * texel;
+
+    mat4_t projection = m4_ortho(light_center.x - radius, light_center.x + radius,
+                                 light_center.y - radius, light_center.y + radius,
+                                 light_center.z - radius, light_center.z + radius + SHADOW_CASTER_MARGIN);
+    cascade->view_projection = m4_mul(projection, light_view);
+    mat4_t bias = m4_mul(m4_translation(vec3(0.5f, 0.5f, 0.5f)), m4_scaling(vec3(0.5f, 0.5f, 0.5f)));
+    cascade->texture_matrix = m4_mul(bias, cascade->view_projection);
+    cascade->texel_world = texel;
+    frustum_from_matrix(&cascade->frustum, cascade->view_projection);
+}
+
+void shadow_map_update(ShadowMap *shadow, const Camera *camera, vec3_t light_dir)
+{
+    if (shadow->cascade_count == 0) {
+        return;
+    }
+
+    // pogled iz koordinatnog pocetka u smeru svetla, kaskade se razlikuju samo po projekciji
+    vec3_t up = fabsf(light_dir.y) > 0.99f ? vec3(0.0f, 0.0f, 1.0f) : vec3(0.0f, 1.0f, 0.0f);
+    mat4_t light_view = m4_look_at(vec3(0.0f, 0.0f, 0.0f), v3_muls(light_dir, -1.0f), up);
+
+    // near iz projekcije kamere: m32 / (m22 - 1)
+    float near = camera->projection.m32 / (camera->projection.m22 - 1.0f);
+    for (int i = 0; i < shadow->cascade_count; ++i) {
+        ShadowCascade *cascade = &shadow->cascades[i];
+        cascade->split_near = split_distance(i, shadow->cascade_count, near, SHADOW_DISTANCE);
+        cascade->split_far = split_distance(i + 1, shadow->cascade_count, near, SHADOW_DISTANCE);
+        update_cascade(cascade, camera, light_view, shadow->resolution);
+    }
+}
+
+void shadow_map_begin(ShadowMap *shadow)
+{
+    glGetIntegerv(GL_FRAMEBUFFER_BINDING, &shadow->saved_framebuffer);
+    glGetIntegerv(GL_VIEWPORT, shadow->saved_viewport);
+    glPolygonMode(GL_FRONT_AND_BACK, GL_FILL);
+    // nagib iz pogleda svetla, protiv "shadow acne" na padinama
+    glEnable(GL_POLYGON_OFFSET_FILL);
+    glPolygonOffset(1.5f, 2.0f);
+}
+
+void shadow_map_begin_cascade(ShadowMap *shadow, int cascade)
+{
+    rafgl_framebuffer_depth_bind_layer(&shadow->framebuffer, cascade);
+    glClear(GL_DEPTH_BUFFER_BIT);
+}
+
+void shadow_map_end(ShadowMap *shadow)
+{
+    glDisable(GL_POLYGON_OFFSET_FILL);
+    glBindFramebuffer(GL_FRAMEBUFFER, shadow->saved_framebuffer);
+    glViewport(shadow->saved_viewport[0], shadow->saved_viewport[1], shadow->saved_viewport[2], shadow->saved_viewport[3]);
+}
+
+void shadow_map_get_uniforms(GLuint program, ShadowUniforms *uniforms)
+{
+    uniforms->map = glGetUniformLocation(program, "u_shadow_map");
+    uniforms->cascades = glGetUniformLocation(program, "u_shadow_cascades");
+    uniforms->matrices = glGetUniformLocation(program, "u_shadow_matrices");
+    uniforms->texel = glGetUniformLocation(program, "u_shadow_texel");
+}
+
+void shadow_map_bind(const ShadowMap *shadow, const ShadowUniforms *uniforms, int texture_unit)
+{
+    int count = shadow ? shadow->cascade_count : 0;
+    glUniform1i(uniforms->cascades, count);
+    glUniform1i(uniforms->map, texture_unit);
+    glActiveTexture(GL_TEXTURE0 + texture_unit);
+    glBindTexture(GL_TEXTURE_2D_ARRAY, count > 0 ? shadow->framebuffer.tex_id : 0);
+    glActiveTexture(GL_TEXTURE0);
+    if (count == 0) {
+        return;
+    }
+
+    float matrices[SHADOW_MAX_CASCADES][16];
+    float texels[SHADOW_MAX_CASCADES];
+    for (int i = 0; i < count; ++i) {
+        memcpy(matrices[i], &shadow->cascades[i].texture_matrix.m[0][0], sizeof(matrices[i]));
+        texels[i] = shadow->cascades[i].texel_world;
+    }
+    glUniformMatrix4fv(uniforms->matrices, count, GL_FALSE, &matrices[0][0]);
+    glUniform1fv(uniforms->texel, count, texels);
+}
+
+void shadow_map_cleanup(ShadowMap *shadow)
+{
+    if (shadow->cascade_count > 0) {
+        rafgl_framebuffer_depth_cleanup(&shadow->framebuffer);
+    }
+    shadow->cascade_count = 0;
+}
@@ -1,11 +1,104 @@
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 #include <math.h>
 #include <terrain.h>
 #include <noise.h>
+#include <thread_pool.h>
+
+typedef struct {
+    Terrain *terrain;
+    const NoiseContext *noise;
+    const float *noise_xs;
+    float scale;
+    int octaves;
+} HeightmapBand;
+
+static void heightmap_rows(void *user, int begin, int end) {
+    HeightmapBand *band = user;
+    int size = band->terrain->size;
+    for (int row = begin; row < end; row++) {
+        float ny = (float)row / size * band->scale;
+        fbm_row_ctx(band->noise, band->noise_xs, ny, size, band->octaves, &band->terrain->heightmap[row * size]);
+    }
+}
+
+// greska LOD-a: visina u punoj rezoluciji naspram interpolacije iz trouglova
+// tog LOD-a (ista dijagonala kao terrain_build_block_indices)
+static void patch_lod_errors(const Terrain *terrain, int pr, int pc, float *out_errors)
+{
+    int size = terrain->size;
+    const float *h = &terrain->heightmap[(pr * PATCH_SIZE) * size + pc * PATCH_SIZE];
+
+    for (int lod = 0; lod < LOD_COUNT; ++lod) {
+        int step = g_lod_steps[lod];
+        float error = 0.0f;
+
+        for (int qr = 0; qr < PATCH_SIZE; qr += step) {
+            for (int qc = 0; qc < PATCH_SIZE; qc += step) {
+                float h00 = h[qr * size + qc];
+                float h01 = h[qr * size + qc + step];
+                float h10 = h[(qr + step) * size + qc];
+                float h11 = h[(qr + step) * size + qc + step];
+
+                for (int r = 0; r <= step; ++r) {
+                    for (int c = 0; c <= step; ++c) {
+                        float u = (float)c / step;
+                        float v = (float)r / step;
+                        float approx = (u >= v)
+                            ? h00 + u * (h01 - h00) + v * (h11 - h01)
+                            : h00 + v * (h10 - h00) + u * (h11 - h10);
+                        float diff = fabsf(h[(qr + r) * size + qc + c] - approx);
+                        if (diff > error) error = diff;
+                    }
+                }
+            }
+        }
 
-void terrain_init(Terrain *terrain, int size) {
+        // grublji lod nikad nije tacniji od finijeg
+        if (lod > 0 && error < out_errors[lod - 1]) {
+            error = out_errors[lod - 1];
+        }
+        out_errors[lod] = error;
+    }
+}
+
+static void patch_height_range_rows(void *user, int begin, int end) {
+    Terrain *terrain = user;
+    int size = terrain->size;
+
+    for (int pr = begin; pr < end; ++pr) {
+        for (int pc = 0; pc < terrain->patch_cols; ++pc) {
+            TerrainPatch *patch = &terrain->patches[pr * terrain->patch_cols + pc];
+            float min_height = INFINITY;
+            float max_height = -INFINITY;
+
+            for (int r = 0; r <= PATCH_SIZE; ++r) {
+                int row = pr * PATCH_SIZE + r;
+                if (row >= size) {
+                    break;
+                }
+                for (int c = 0; c <= PATCH_SIZE; ++c) {
+                    int col = pc * PATCH_SIZE + c;
+                    if (col >= size) {
+                        break;
+                    }
+                    float h = terrain->heightmap[row * size + col];
+                    if (h < min_height) min_height = h;
+                    if (h > max_height) max_height = h;
+                }
+            }
+
+            patch->min_height = min_height;
+            patch->max_height = max_height;
+            patch_lod_errors(terrain, pr, pc, patch->lod_error);
+        }
+    }
+}
+
+void terrain_init(Terrain *terrain, int size, uint32_t seed) {
     terrain->size = size;
+    terrain->seed = seed;
     terrain->spacing = 1.0f;
     terrain->height_scale = 1.0f;
 
@@ -24,330 +117,768 @@ void terrain_init(Terrain *terrain, int size) {
             TerrainPatch *patch = &terrain->patches[patch_index];
             patch->lod_levels = LOD_COUNT;
             patch->origin = vec2_make((float)(pc * PATCH_SIZE), (float)(pr * PATCH_SIZE));
+            patch->base_vertex = patch_index * PATCH_BLOCK_VERTICES;
         }
     }
 
+    // svaki patch ima svoj blok (grid + skirtovi za rupe izmedju patchova)
     int grid_vertex_count = size * size;
-    int extra_vertices = terrain->patch_count * PATCH_SKIRT_VERTICES; // za rupe izmedju patchova
-    terrain->vertex_count = grid_vertex_count + extra_vertices;
+    terrain->vertex_count = terrain->patch_count * PATCH_BLOCK_VERTICES;
     
-    noise_init();
+    noise_context_init(&terrain->noise, seed);
     
     
-    terrain->heightmap = malloc(terrain->vertex_count * sizeof(float));
+    terrain->heightmap = malloc(grid_vertex_count * sizeof(float));
     
-    float scale = 5.0f;
-    int octaves = 10; // sto veci broj vise detalja
+    float scale = TERRAIN_NOISE_SCALE;
+    int octaves = TERRAIN_NOISE_OCTAVES;
     
-    for (int row = 0; row < size; row++) {
-        for (int col = 0; col < size; col++) {
-            float nx = (float)col / size * scale;
-            float ny = (float)row / size * scale;
-            
-            float noise_val = fbm(nx, ny, octaves);
-            
-            terrain->heightmap[row * size + col] = noise_val;
-        }
+    // x koordinate su iste za svaki red, fbm_row racuna ceo red odjednom
+    float *noise_xs = malloc(size * sizeof(float));
+    for (int col = 0; col < size; col++) {
+        noise_xs[col] = (float)col / size * scale;
     }
+
+    // svaki red je nezavisan pa je rezultat isti bez obzira na broj niti
+    HeightmapBand band = { terrain, &terrain->noise, noise_xs, scale, octaves };
+    thread_pool_parallel_for(thread_pool_shared(), size, heightmap_rows, &band);
+    free(noise_xs);
+
+    thread_pool_parallel_for(thread_pool_shared(), terrain->patch_rows, patch_height_range_rows, terrain);
     
-    terrain->vertices = malloc(terrain->vertex_count * sizeof(Vertex));
+    // vertexi se alociraju u terrain_generate_vertices, kad je format poznat
+    terrain->vertex_format = TERRAIN_VERTEX_FULL;
+    terrain->vertices = NULL;
+    terrain->compact_vertices = NULL;
 
-    printf("Terrain initialized: %dx%d grid, %d base vertices, %d patches\n", 
-           size, size, grid_vertex_count, terrain->patch_count);
+    printf("Terrain initialized: %dx%d grid, %d block vertices, %d patches, seed %u\n", 
+           size, size, terrain->vertex_count, terrain->patch_count, seed);
 }
 
-void terrain_generate_vertices(Terrain *terrain, float spacing, float height_scale) {
+static inline int clamp_to_grid(int value, int max_value)
+{
+    if (value < 0) {
+        return 0;
+    }
+    if (value > max_value) {
+        return max_value;
+    }
+    return value;
+}
+
+static vec3_t grid_normal(const Terrain *terrain, int row, int col)
+{
     int size = terrain->size;
-    terrain->spacing = spacing;
-    terrain->height_scale = height_scale;
-    terrain->patch_world_stride = PATCH_SIZE * spacing;
+    float height_scale = terrain->height_scale;
+
+    // susedni vertexi
+    int col_left  = (col > 0) ? col - 1 : col;
+    int col_right = (col < size - 1) ? col + 1 : col;
+    int row_up    = (row > 0) ? row - 1 : row;
+    int row_down  = (row < size - 1) ? row + 1 : row;
     
+    float height_left  = terrain->heightmap[row * size + col_left] * height_scale;
+    float height_right = terrain->heightmap[row * size + col_right] * height_scale;
+    float height_up    = terrain->heightmap[row_up * size + col] * height_scale;
+    float height_down  = terrain->heightmap[row_down * size + col] * height_scale;
     
-    float offset = (size - 1) * spacing / 2.0f;
+    // Calculate normal using cross product of tangent vectors
+    // Tangent X: from left to right
+    // Tangent Z: from up to down
+    float nx = height_left - height_right;
+    float nz = height_up - height_down;
+    float ny = 2.0f * terrain->spacing;
     
-    // generisanje vertexa
-    for (int row = 0; row < size; row++) {
-        for (int col = 0; col < size; col++) {
-            int index = row * size + col;
-            
-            float x = col * spacing - offset;
-            float y = terrain->heightmap[index] * height_scale;
-            float z = row * spacing - offset;
-            float u = (float)col / size;
-            float v = (float)row / size;
-            
-            terrain->vertices[index] = vertex_create(x, y, z, u, v, 0.0f, 1.0f, 0.0f);
-        }
+    // normalizujemo vektor
+    float length = sqrtf(nx * nx + ny * ny + nz * nz);
+    if (length > 0.0001f) {
+        nx /= length;
+        ny /= length;
+        nz /= length;
     }
+    return vec3(nx, ny, nz);
+}
 
-    int grid_vertex_count = size * size;
-    // hardkodovano
-    float skirt_normal_x = 0.0f;
-    float skirt_normal_y = -1.0f;
-    float skirt_normal_z = 0.0f;
+Vertex terrain_grid_vertex(const Terrain *terrain, int row, int col)
+{
+    int size = terrain->size;
+    row = clamp_to_grid(row, size - 1);
+    col = clamp_to_grid(col, size - 1);
+
+    float offset = (size - 1) * terrain->spacing / 2.0f;
+    vec3_t n = grid_normal(terrain, row, col);
+    return vertex_create(col * terrain->spacing - offset,
+                         terrain->heightmap[row * size + col] * terrain->height_scale,
+                         row * terrain->spacing - offset,
+                         (float)col / size, (float)row / size,
+                         n.x, n.y, n.z);
+}
 
-    int patch_index = 0;
-    for (int pr = 0; pr < terrain->patch_rows; ++pr) {
+static void block_vertex_rows(void *user, int begin, int end) {
+    Terrain *terrain = user;
+    int size = terrain->size;
+    int max_index = size - 1;
+    float spacing = terrain->spacing;
+    float height_scale = terrain->height_scale;
+    float offset = (size - 1) * spacing / 2.0f;
+
+    for (int pr = begin; pr < end; ++pr) {
         for (int pc = 0; pc < terrain->patch_cols; ++pc) {
-            int start_row = pr * PATCH_SIZE;
-            int start_col = pc * PATCH_SIZE;
-            int skirt_start = grid_vertex_count + patch_index * PATCH_SKIRT_VERTICES;
-            int cursor = skirt_start;
-
-            // gornja ivica
-            for (int i = 0; i <= PATCH_SIZE; ++i) {
-                int col = start_col + i;
-                int row = start_row;
-                if (col >= size) col = size - 1;
-                if (row >= size) row = size - 1;
-                int src_index = row * size + col;
-                Vertex base = terrain->vertices[src_index];
-                base.y -= SKIRT_DEPTH;
-                base.nx = skirt_normal_x;
-                base.ny = skirt_normal_y;
-                base.nz = skirt_normal_z;
-                terrain->vertices[cursor++] = base;
+            TerrainPatch *patch = &terrain->patches[pr * terrain->patch_cols + pc];
+            Vertex *block = &terrain->vertices[patch->base_vertex];
+
+            // generisanje vertexa, ivice se dupliraju izmedju susednih patchova
+            for (int r = 0; r <= PATCH_SIZE; ++r) {
+                int row = clamp_to_grid(pr * PATCH_SIZE + r, max_index);
+                for (int c = 0; c <= PATCH_SIZE; ++c) {
+                    int col = clamp_to_grid(pc * PATCH_SIZE + c, max_index);
+                    
+                    float x = col * spacing - offset;
+                    float y = terrain->heightmap[row * size + col] * height_scale;
+                    float z = row * spacing - offset;
+                    float u = (float)col / size;
+                    float v = (float)row / size;
+                    
+                    block[r * (PATCH_SIZE + 1) + c] = vertex_create(x, y, z, u, v, 0.0f, 1.0f, 0.0f);
+                }
             }
 
-            // desna ivica
-            for (int i = 0; i <= PATCH_SIZE; ++i) {
-                int col = start_col + PATCH_SIZE;
-                int row = start_row + i;
-                if (col >= size) col = size - 1;
-                if (row >= size) row = size - 1;
-                int src_index = row * size + col;
-                Vertex base = terrain->vertices[src_index];
-                base.y -= SKIRT_DEPTH;
-                base.nx = skirt_normal_x;
-                base.ny = skirt_normal_y;
-                base.nz = skirt_normal_z;
-                terrain->vertices[cursor++] = base;
-            }
+            terrain_block_build_skirts(block);
+        }
+    }
+}
 
-            // donja ivica
-            for (int i = 0; i <= PATCH_SIZE; ++i) {
-                int col = start_col + (PATCH_SIZE - i);
-                int row = start_row + PATCH_SIZE;
-                if (col >= size) col = size - 1;
-                if (row >= size) row = size - 1;
-                int src_index = row * size + col;
-                Vertex base = terrain->vertices[src_index];
-                base.y -= SKIRT_DEPTH;
-                base.nx = skirt_normal_x;
-                base.ny = skirt_normal_y;
-                base.nz = skirt_normal_z;
-                terrain->vertices[cursor++] = base;
-            }
+static uint16_t quantize_height(const Terrain *terrain, float y)
+{
+    float t = (y - terrain->compact_height_min) / terrain->compact_height_range;
+    if (t < 0.0f) t = 0.0f;
+    if (t > 1.0f) t = 1.0f;
+    return (uint16_t)lrintf(t * 65535.0f);
+}
+
+static int8_t snorm8(float value)
+{
+    return (int8_t)lrintf(fmaxf(-1.0f, fminf(1.0f, value)) * 127.0f);
+}
 
-            // leva ivica
-            for (int i = 0; i <= PATCH_SIZE; ++i) {
-                int col = start_col;
-                int row = start_row + (PATCH_SIZE - i);
-                if (col >= size) col = size - 1;
-                if (row >= size) row = size - 1;
-                int src_index = row * size + col;
-                Vertex base = terrain->vertices[src_index];
-                base.y -= SKIRT_DEPTH;
-                base.nx = skirt_normal_x;
-                base.ny = skirt_normal_y;
-                base.nz = skirt_normal_z;
-                terrain->vertices[cursor++] = base;
+// oktaedarsko kodiranje oko y ose, isto dekodiranje je u terrain vert.glsl
+static void encode_normal(vec3_t n, int8_t out[2])
+{
+    float sum = fabsf(n.x) + fabsf(n.y) + fabsf(n.z);
+    float ex = n.x / sum;
+    float ez = n.z / sum;
+    if (n.y < 0.0f) {
+        float fx = (1.0f - fabsf(ez)) * (ex >= 0.0f ? 1.0f : -1.0f);
+        float fz = (1.0f - fabsf(ex)) * (ez >= 0.0f ? 1.0f : -1.0f);
+        ex = fx;
+        ez = fz;
+    }
+    out[0] = snorm8(ex);
+    out[1] = snorm8(ez);
+}
+
+static void compact_block_vertex_rows(void *user, int begin, int end) {
+    Terrain *terrain = user;
+    int size = terrain->size;
+    int max_index = size - 1;
+    const int stride = PATCH_SIZE + 1;
+
+    for (int pr = begin; pr < end; ++pr) {
+        for (int pc = 0; pc < terrain->patch_cols; ++pc) {
+            TerrainPatch *patch = &terrain->patches[pr * terrain->patch_cols + pc];
+            TerrainCompactVertex *block = &terrain->compact_vertices[patch->base_vertex];
+
+            for (int r = 0; r <= PATCH_SIZE; ++r) {
+                int row = clamp_to_grid(pr * PATCH_SIZE + r, max_index);
+                for (int c = 0; c <= PATCH_SIZE; ++c) {
+                    int col = clamp_to_grid(pc * PATCH_SIZE + c, max_index);
+                    float y = terrain->heightmap[row * size + col] * terrain->height_scale;
+                    block[r * stride + c].height = quantize_height(terrain, y);
+                    block[r * stride + c].normal[0] = 0;
+                    block[r * stride + c].normal[1] = 0;
+                }
             }
 
-            patch_index++;
+            // skirtovi istim redom kao terrain_block_build_skirts, visina je vec spustena
+            int cursor = PATCH_GRID_VERTICES;
+            int8_t down[2];
+            encode_normal(vec3(0.0f, -1.0f, 0.0f), down);
+            for (int edge = 0; edge < (TERRAIN_SKIRTS ? 4 : 0); ++edge) {
+                for (int i = 0; i <= PATCH_SIZE; ++i) {
+                    int r, c;
+                    switch (edge) {
+                    case 0:  r = 0;              c = i;              break;
+                    case 1:  r = i;              c = PATCH_SIZE;     break;
+                    case 2:  r = PATCH_SIZE;     c = PATCH_SIZE - i; break;
+                    default: r = PATCH_SIZE - i; c = 0;              break;
+                    }
+                    int row = clamp_to_grid(pr * PATCH_SIZE + r, max_index);
+                    int col = clamp_to_grid(pc * PATCH_SIZE + c, max_index);
+                    float y = terrain->heightmap[row * size + col] * terrain->height_scale - SKIRT_DEPTH;
+                    block[cursor].height = quantize_height(terrain, y);
+                    block[cursor].normal[0] = down[0];
+                    block[cursor].normal[1] = down[1];
+                    cursor++;
+                }
+            }
         }
     }
-    
-    printf("Vertices generated: spacing=%.2f, height_scale=%.2f\n", spacing, height_scale);
 }
 
-static inline int clamp_to_grid(int value, int max_value)
+size_t terrain_vertex_stride(TerrainVertexFormat format)
 {
-    if (value < 0) {
-        return 0;
+    switch (format) {
+    case TERRAIN_VERTEX_COMPACT:   return sizeof(TerrainCompactVertex);
+    case TERRAIN_VERTEX_HEIGHTMAP: return 0;
+    default:                       return sizeof(Vertex);
     }
-    if (value > max_value) {
-        return max_value;
+}
+
+const void *terrain_vertex_data(const Terrain *terrain)
+{
+    switch (terrain->vertex_format) {
+    case TERRAIN_VERTEX_COMPACT:   return terrain->compact_vertices;
+    case TERRAIN_VERTEX_HEIGHTMAP: return NULL;
+    default:                       return terrain->vertices;
     }
-    return value;
 }
 
-void terrain_calculate_normals(Terrain *terrain) {
-    int size = terrain->size;
-    float spacing = terrain->spacing;
-    float height_scale = terrain->height_scale;
+void terrain_generate_vertices(Terrain *terrain, float spacing, float height_scale) {
+    terrain->spacing = spacing;
+    terrain->height_scale = height_scale;
+    terrain->patch_world_stride = PATCH_SIZE * spacing;
+
+    // opseg visina za kvantizaciju, skirtovi idu SKIRT_DEPTH ispod
+    float min_height = INFINITY;
+    float max_height = -INFINITY;
+    for (int i = 0; i < terrain->patch_count; ++i) {
+        float a = terrain->patches[i].min_height * height_scale;
+        float b = terrain->patches[i].max_height * height_scale;
+        min_height = fminf(min_height, fminf(a, b));
+        max_height = fmaxf(max_height, fmaxf(a, b));
+    }
+    terrain->compact_height_min = min_height - SKIRT_DEPTH;
+    terrain->compact_height_range = fmaxf(max_height - terrain->compact_height_min, 0.0001f);
+    
+    // svaki patch ima svoj blok pa trake patch redova ne dele nista
+    if (terrain->vertex_format == TERRAIN_VERTEX_HEIGHTMAP) {
+        // vertexi se ne prave, vertex shader cita visinu iz terrain_heightmap_texture_create
+    } else if (terrain->vertex_format == TERRAIN_VERTEX_COMPACT) {
+        terrain->compact_vertices = malloc(terrain->vertex_count * sizeof(TerrainCompactVertex));
+        thread_pool_parallel_for(thread_pool_shared(), terrain->patch_rows, compact_block_vertex_rows, terrain);
+    } else {
+        terrain->vertices = malloc(terrain->vertex_count * sizeof(Vertex));
+        thread_pool_parallel_for(thread_pool_shared(), terrain->patch_rows, block_vertex_rows, terrain);
+    }
     
-    for (int row = 0; row < size; row++) {
-        for (int col = 0; col < size; col++) {
-            int index = row * size + col;
-            
-            // susedni vertexi
-            int col_left  = (col > 0) ? col - 1 : col;
-            int col_right = (col < size - 1) ? col + 1 : col;
-            int row_up    = (row > 0) ? row - 1 : row;
-            int row_down  = (row < size - 1) ? row + 1 : row;
-            
-            float height_left  = terrain->heightmap[row * size + col_left] * height_scale;
-            float height_right = terrain->heightmap[row * size + col_right] * height_scale;
-            float height_up    = terrain->heightmap[row_up * size + col] * height_scale;
-            float height_down  = terrain->heightmap[row_down * size + col] * height_scale;
-            
-            // Calculate normal using cross product of tangent vectors
-            // Tangent X: from left to right
-            // Tangent Z: from up to down
-            float nx = height_left - height_right;
-            float nz = height_up - height_down;
-            float ny = 2.0f * spacing;
-            
-            // normalizujemo vektor
-            float length = sqrtf(nx * nx + ny * ny + nz * nz);
-            if (length > 0.0001f) {
-                nx /= length;
-                ny /= length;
-                nz /= length;
+    printf("Vertices generated: spacing=%.2f, height_scale=%.2f\n", spacing, height_scale);
+    static const char *format_names[] = { "full", "compact", "heightmap" };
+    printf("Terrain vertex memory: full %.1f MB, compact %.1f MB, heightmap texture %.1f MB (using %s)\n",
+           terrain->vertex_count * sizeof(Vertex) / (1024.0 * 1024.0),
+           terrain->vertex_count * sizeof(TerrainCompactVertex) / (1024.0 * 1024.0),
+           (double)terrain->size * terrain->size * sizeof(uint16_t) / (1024.0 * 1024.0),
+           format_names[terrain->vertex_format]);
+}
+
+static void block_normal_rows(void *user, int begin, int end) {
+    Terrain *terrain = user;
+    int max_index = terrain->size - 1;
+
+    for (int pr = begin; pr < end; ++pr) {
+        for (int pc = 0; pc < terrain->patch_cols; ++pc) {
+            TerrainPatch *patch = &terrain->patches[pr * terrain->patch_cols + pc];
+
+            if (terrain->vertex_format == TERRAIN_VERTEX_COMPACT) {
+                TerrainCompactVertex *block = &terrain->compact_vertices[patch->base_vertex];
+                for (int r = 0; r <= PATCH_SIZE; ++r) {
+                    int row = clamp_to_grid(pr * PATCH_SIZE + r, max_index);
+                    for (int c = 0; c <= PATCH_SIZE; ++c) {
+                        int col = clamp_to_grid(pc * PATCH_SIZE + c, max_index);
+                        encode_normal(grid_normal(terrain, row, col), block[r * (PATCH_SIZE + 1) + c].normal);
+                    }
+                }
+                continue;
+            }
+
+            Vertex *block = &terrain->vertices[patch->base_vertex];
+
+            for (int r = 0; r <= PATCH_SIZE; ++r) {
+                int row = clamp_to_grid(pr * PATCH_SIZE + r, max_index);
+                for (int c = 0; c <= PATCH_SIZE; ++c) {
+                    int col = clamp_to_grid(pc * PATCH_SIZE + c, max_index);
+                    vec3_t n = grid_normal(terrain, row, col);
+                    Vertex *vertex = &block[r * (PATCH_SIZE + 1) + c];
+                    vertex->nx = n.x;
+                    vertex->ny = n.y;
+                    vertex->nz = n.z;
+                }
             }
-            
-            terrain->vertices[index].nx = nx;
-            terrain->vertices[index].ny = ny;
-            terrain->vertices[index].nz = nz;
         }
     }
+}
+
+void terrain_calculate_normals(Terrain *terrain) {
+    if (terrain->vertex_format == TERRAIN_VERTEX_HEIGHTMAP) {
+        return; // normale se racunaju u vertex shaderu
+    }
+    thread_pool_parallel_for(thread_pool_shared(), terrain->patch_rows, block_normal_rows, terrain);
     
     printf("Normals calculated for %d vertices\n", terrain->vertex_count);
 }
 
-static unsigned int *build_patch_indices_internal(const Terrain *terrain, const TerrainPatch *patch, int lod_step, int *out_index_count)
+void terrain_patch_bounds(const Terrain *terrain, const TerrainPatch *patch, vec3_t *out_min, vec3_t *out_max)
 {
-    int start_row = (int)patch->origin.y;
-    int start_col = (int)patch->origin.x;
-    int size = terrain->size;
-    int max_index = size - 1;
+    float offset = (terrain->size - 1) * terrain->spacing / 2.0f;
+    float x0 = patch->origin.x * terrain->spacing - offset;
+    float z0 = patch->origin.y * terrain->spacing - offset;
+
+    // height_scale moze biti negativan, pa uzimamo min/max posle skaliranja
+    float y0 = patch->min_height * terrain->height_scale;
+    float y1 = patch->max_height * terrain->height_scale;
+    if (y0 > y1) {
+        float tmp = y0;
+        y0 = y1;
+        y1 = tmp;
+    }
+
+    *out_min = vec3(x0, y0 - SKIRT_DEPTH, z0);
+    *out_max = vec3(x0 + terrain->patch_world_stride, y1, z0 + terrain->patch_world_stride);
+}
+
+int terrain_lod_for_distance(float distance)
+{
+    int lod = 0;
+    if (distance > 120.0f) {
+        lod = 2;
+    } else if (distance > 60.0f) {
+        lod = 1;
+    }
+    return lod < LOD_COUNT ? lod : LOD_COUNT - 1;
+}
+
+static float axis_distance(float p, float lo, float hi)
+{
+    if (p < lo) return lo - p;
+    if (p > hi) return p - hi;
+    return 0.0f;
+}
+
+void terrain_select_lods(const Terrain *terrain, vec3_t camera_pos, float lod_scale, float pixel_tolerance, int *out_lods)
+{
+    // greska u svetu koja se na udaljenosti d vidi kao pixel_tolerance piksela je d * tolerance / lod_scale
+    float world_per_distance = pixel_tolerance / lod_scale;
+    float error_scale = fabsf(terrain->height_scale);
+
+    for (int i = 0; i < terrain->patch_count; ++i) {
+        const TerrainPatch *patch = &terrain->patches[i];
+        vec3_t bounds_min, bounds_max;
+        terrain_patch_bounds(terrain, patch, &bounds_min, &bounds_max);
+
+        // najbliza tacka AABB-a, pa visina kamere i strmina patcha ulaze u izbor
+        float dx = axis_distance(camera_pos.x, bounds_min.x, bounds_max.x);
+        float dy = axis_distance(camera_pos.y, bounds_min.y, bounds_max.y);
+        float dz = axis_distance(camera_pos.z, bounds_min.z, bounds_max.z);
+        float allowed_error = sqrtf(dx * dx + dy * dy + dz * dz) * world_per_distance;
+
+        int lod = patch->lod_levels - 1;
+        while (lod > 0 && patch->lod_error[lod] * error_scale > allowed_error) {
+            lod--;
+        }
+        out_lods[i] = lod;
+    }
+
+    // sivenje radi samo za razliku od jednog nivoa, pa grublje patchove
+    // pored finijih spustamo dok se to ne ispuni
+    int changed = 1;
+    while (changed) {
+        changed = 0;
+        for (int pr = 0; pr < terrain->patch_rows; ++pr) {
+            for (int pc = 0; pc < terrain->patch_cols; ++pc) {
+                int i = pr * terrain->patch_cols + pc;
+                int finest = out_lods[i];
+                if (pr > 0 && out_lods[i - terrain->patch_cols] < finest) finest = out_lods[i - terrain->patch_cols];
+                if (pr < terrain->patch_rows - 1 && out_lods[i + terrain->patch_cols] < finest) finest = out_lods[i + terrain->patch_cols];
+                if (pc > 0 && out_lods[i - 1] < finest) finest = out_lods[i - 1];
+                if (pc < terrain->patch_cols - 1 && out_lods[i + 1] < finest) finest = out_lods[i + 1];
+                if (out_lods[i] > finest + 1) {
+                    out_lods[i] = finest + 1;
+                    changed = 1;
+                }
+            }
+        }
+    }
+}
+
+int terrain_patch_edge_mask(const Terrain *terrain, const int *lods, int patch_index)
+{
+    int cols = terrain->patch_cols;
+    int pr = patch_index / cols;
+    int pc = patch_index % cols;
+    int lod = lods[patch_index];
+
+    int mask = 0;
+    if (pr > 0 && lods[patch_index - cols] > lod) mask |= TERRAIN_EDGE_TOP;
+    if (pc < cols - 1 && lods[patch_index + 1] > lod) mask |= TERRAIN_EDGE_RIGHT;
+    if (pr < terrain->patch_rows - 1 && lods[patch_index + cols] > lod) mask |= TERRAIN_EDGE_BOTTOM;
+    if (pc > 0 && lods[patch_index - 1] > lod) mask |= TERRAIN_EDGE_LEFT;
+    return mask;
+}
+
+// vertex na ivici koja se spaja sa grubljim susedom: tacke kojih kod suseda
+// nema se spajaju sa prethodnom, pa ivica ima iste vertexe kao susedova
+static int stitch_vertex(int v, int lod_step, int edge_mask)
+{
+    const int stride = PATCH_SIZE + 1;
+    int coarse_step = lod_step * 2;
+    if (coarse_step > PATCH_SIZE) {
+        return v; // najgrublji lod nema grubljeg suseda
+    }
+
+    if (v >= PATCH_GRID_VERTICES) {
+        // skirt: donja i leva traka idu unazad po koloni/redu
+        int skirt = v - PATCH_GRID_VERTICES;
+        int edge = skirt / stride;
+        int i = skirt % stride;
+        if ((edge_mask & (1 << edge)) && i % coarse_step != 0) {
+            i += edge < 2 ? -lod_step : lod_step;
+        }
+        return PATCH_GRID_VERTICES + edge * stride + i;
+    }
+
+    int row = v / stride;
+    int col = v % stride;
+    if (((row == 0 && (edge_mask & TERRAIN_EDGE_TOP)) ||
+         (row == PATCH_SIZE && (edge_mask & TERRAIN_EDGE_BOTTOM))) && col % coarse_step != 0) {
+        col -= lod_step;
+    } else if (((col == PATCH_SIZE && (edge_mask & TERRAIN_EDGE_RIGHT)) ||
+                (col == 0 && (edge_mask & TERRAIN_EDGE_LEFT))) && row % coarse_step != 0) {
+        row -= lod_step;
+    }
+    return row * stride + col;
+}
 
+// degenerisani trouglovi posle spajanja se preskacu
+static int emit_triangle(TerrainIndex *indices, int idx, int a, int b, int c, int lod_step, int edge_mask)
+{
+    a = stitch_vertex(a, lod_step, edge_mask);
+    b = stitch_vertex(b, lod_step, edge_mask);
+    c = stitch_vertex(c, lod_step, edge_mask);
+    if (a == b || b == c || a == c) {
+        return idx;
+    }
+    indices[idx++] = a;
+    indices[idx++] = b;
+    indices[idx++] = c;
+    return idx;
+}
+
+TerrainIndex *terrain_build_block_indices(int lod_step, int edge_mask, int *out_index_count)
+{
+    const int stride = PATCH_SIZE + 1;
     int quads_per_side = PATCH_SIZE / lod_step;
-    int base_triangle_count = quads_per_side * quads_per_side * 2;
-    int base_index_count = base_triangle_count * 3;
-    int skirt_segments = 4 * quads_per_side;
-    int skirt_index_count = skirt_segments * 6;
-    int total_index_count = base_index_count + skirt_index_count;
+    int total_index_count = quads_per_side * quads_per_side * 6 + (TERRAIN_SKIRTS ? 4 * quads_per_side * 6 : 0);
 
-    unsigned int *indices = malloc(total_index_count * sizeof(unsigned int));
+    TerrainIndex *indices = malloc(total_index_count * sizeof(TerrainIndex));
     if (!indices) {
         *out_index_count = 0;
         return NULL;
     }
 
     int idx = 0;
-    // pravljenje ibo
     for (int row = 0; row < PATCH_SIZE; row += lod_step) {
-        int global_row = clamp_to_grid(start_row + row, max_index);
-        int global_row_next = clamp_to_grid(start_row + row + lod_step, max_index);
         for (int col = 0; col < PATCH_SIZE; col += lod_step) {
-            int global_col = clamp_to_grid(start_col + col, max_index);
-            int global_col_next = clamp_to_grid(start_col + col + lod_step, max_index);
-
-            int top_left = global_row * size + global_col;
-            int top_right = global_row * size + global_col_next;
-            int bottom_left = global_row_next * size + global_col;
-            int bottom_right = global_row_next * size + global_col_next;
-
-            indices[idx++] = top_left;
-            indices[idx++] = top_right;
-            indices[idx++] = bottom_right;
+            int top_left = row * stride + col;
+            int top_right = row * stride + col + lod_step;
+            int bottom_left = (row + lod_step) * stride + col;
+            int bottom_right = (row + lod_step) * stride + col + lod_step;
 
-            indices[idx++] = top_left;
-            indices[idx++] = bottom_right;
-            indices[idx++] = bottom_left;
+            idx = emit_triangle(indices, idx, top_left, top_right, bottom_right, lod_step, edge_mask);
+            idx = emit_triangle(indices, idx, top_left, bottom_right, bottom_left, lod_step, edge_mask);
         }
     }
 
-    int grid_vertex_count = size * size;
-    int patch_index = (int)(patch - terrain->patches);
-    int skirt_start = grid_vertex_count + patch_index * PATCH_SKIRT_VERTICES;
-    int edge_vert_count = PATCH_SIZE + 1;
+    if (!TERRAIN_SKIRTS) {
+        *out_index_count = idx;
+        return indices;
+    }
 
-    int top_offset = skirt_start;
-    int right_offset = top_offset + edge_vert_count;
-    int bottom_offset = right_offset + edge_vert_count;
-    int left_offset = bottom_offset + edge_vert_count;
+    int top_offset = PATCH_GRID_VERTICES;
+    int right_offset = top_offset + stride;
+    int bottom_offset = right_offset + stride;
+    int left_offset = bottom_offset + stride;
 
+    // isti redosled kao skirtovi u terrain_block_build_skirts
     for (int seg = 0; seg < quads_per_side; ++seg) {
         int offset = seg * lod_step;
         int next_offset = offset + lod_step;
 
-        // gornja ivica
-        int top_row = clamp_to_grid(start_row, max_index);
-        int v0 = clamp_to_grid(start_col + offset, max_index);
-        int v1 = clamp_to_grid(start_col + next_offset, max_index);
-        int top_v0 = top_row * size + v0;
-        int top_v1 = top_row * size + v1;
-        int top_s0 = top_offset + offset;
-        int top_s1 = top_offset + next_offset;
-
-        indices[idx++] = top_v0;
-        indices[idx++] = top_v1;
-        indices[idx++] = top_s1;
-
-        indices[idx++] = top_v0;
-        indices[idx++] = top_s1;
-        indices[idx++] = top_s0;
-
-        // desna ivica
-        int right_col = clamp_to_grid(start_col + PATCH_SIZE, max_index);
-        int r0 = clamp_to_grid(start_row + offset, max_index);
-        int r1 = clamp_to_grid(start_row + next_offset, max_index);
-        int right_v0 = r0 * size + right_col;
-        int right_v1 = r1 * size + right_col;
-        int right_s0 = right_offset + offset;
-        int right_s1 = right_offset + next_offset;
-
-        indices[idx++] = right_v0;
-        indices[idx++] = right_v1;
-        indices[idx++] = right_s1;
-
-        indices[idx++] = right_v0;
-        indices[idx++] = right_s1;
-        indices[idx++] = right_s0;
-
-        // donja ivica
-        int bottom_row = clamp_to_grid(start_row + PATCH_SIZE, max_index);
-        int b_col0 = clamp_to_grid(start_col + PATCH_SIZE - offset, max_index);
-        int b_col1 = clamp_to_grid(start_col + PATCH_SIZE - next_offset, max_index);
-        int bottom_v0 = bottom_row * size + b_col0;
-        int bottom_v1 = bottom_row * size + b_col1;
-        int bottom_s0 = bottom_offset + offset;
-        int bottom_s1 = bottom_offset + next_offset;
-
-        indices[idx++] = bottom_v0;
-        indices[idx++] = bottom_v1;
-        indices[idx++] = bottom_s1;
-
-        indices[idx++] = bottom_v0;
-        indices[idx++] = bottom_s1;
-        indices[idx++] = bottom_s0;
-
-        // leva ivica
-        int left_col = clamp_to_grid(start_col, max_index);
-        int l_row0 = clamp_to_grid(start_row + PATCH_SIZE - offset, max_index);
-        int l_row1 = clamp_to_grid(start_row + PATCH_SIZE - next_offset, max_index);
-        int left_v0 = l_row0 * size + left_col;
-        int left_v1 = l_row1 * size + left_col;
-        int left_s0 = left_offset + offset;
-        int left_s1 = left_offset + next_offset;
-
-        indices[idx++] = left_v0;
-        indices[idx++] = left_v1;
-        indices[idx++] = left_s1;
-
-        indices[idx++] = left_v0;
-        indices[idx++] = left_s1;
-        indices[idx++] = left_s0;
+        int edge_v[4][2] = {
+            { offset, next_offset },                                                         // gornja
+            { offset * stride + PATCH_SIZE, next_offset * stride + PATCH_SIZE },             // desna
+            { PATCH_SIZE * stride + PATCH_SIZE - offset, PATCH_SIZE * stride + PATCH_SIZE - next_offset }, // donja
+            { (PATCH_SIZE - offset) * stride, (PATCH_SIZE - next_offset) * stride }          // leva
+        };
+        int skirt_offsets[4] = { top_offset, right_offset, bottom_offset, left_offset };
+
+        for (int edge = 0; edge < 4; ++edge) {
+            int v0 = edge_v[edge][0];
+            int v1 = edge_v[edge][1];
+            int s0 = skirt_offsets[edge] + offset;
+            int s1 = skirt_offsets[edge] + next_offset;
+
+            idx = emit_triangle(indices, idx, v0, v1, s1, lod_step, edge_mask);
+            idx = emit_triangle(indices, idx, v0, s1, s0, lod_step, edge_mask);
+        }
     }
 
     *out_index_count = idx;
     return indices;
 }
 
-unsigned int *terrain_build_patch_indices(const Terrain *terrain, const TerrainPatch *patch, int lod_step, int *out_index_count)
+void terrain_block_build_skirts(Vertex *block)
 {
-    return build_patch_indices_internal(terrain, patch, lod_step, out_index_count);
+    if (!TERRAIN_SKIRTS) {
+        return;
+    }
+
+    const int stride = PATCH_SIZE + 1;
+    int cursor = PATCH_GRID_VERTICES;
+
+    for (int edge = 0; edge < 4; ++edge) {
+        for (int i = 0; i <= PATCH_SIZE; ++i) {
+            int row, col;
+            switch (edge) {
+            case 0:  row = 0;              col = i;              break; // gornja
+            case 1:  row = i;              col = PATCH_SIZE;     break; // desna
+            case 2:  row = PATCH_SIZE;     col = PATCH_SIZE - i; break; // donja
+            default: row = PATCH_SIZE - i; col = 0;              break; // leva
+            }
+            Vertex base = block[row * stride + col];
+            base.y -= SKIRT_DEPTH;
+            base.nx = 0.0f;
+            base.ny = -1.0f;
+            base.nz = 0.0f;
+            block[cursor++] = base;
+        }
+    }
+}
+
+GLuint terrain_heightmap_texture_create(const Terrain *terrain)
+{
+    int size = terrain->size;
+    uint16_t *texels = malloc((size_t)size * size * sizeof(uint16_t));
+    if (!texels) {
+        return 0;
+    }
+    for (int i = 0; i < size * size; ++i) {
+        texels[i] = quantize_height(terrain, terrain->heightmap[i] * terrain->height_scale);
+    }
+
+    GLuint texture;
+    glGenTextures(1, &texture);
+    glBindTexture(GL_TEXTURE_2D, texture);
+    // vertex shader radi texelFetch, filtriranje i mipovi ne trebaju
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 2);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_R16, size, size, 0, GL_RED, GL_UNSIGNED_SHORT, texels);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+    glBindTexture(GL_TEXTURE_2D, 0);
+
+    free(texels);
+    return texture;
+}
+
+void terrain_lod_indices_create(TerrainLodIndices *lod_indices)
+{
+    TerrainIndex *built[LOD_COUNT][TERRAIN_EDGE_VARIANTS];
+    int total = 0;
+    for (int lod = 0; lod < LOD_COUNT; ++lod) {
+        for (int mask = 0; mask < TERRAIN_EDGE_VARIANTS; ++mask) {
+            built[lod][mask] = terrain_build_block_indices(g_lod_steps[lod], mask, &lod_indices->counts[lod][mask]);
+            lod_indices->offsets[lod][mask] = total;
+            total += lod_indices->counts[lod][mask];
+        }
+    }
+
+    glGenBuffers(1, &lod_indices->buffer);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, lod_indices->buffer);
+    glBufferData(GL_ELEMENT_ARRAY_BUFFER, total * sizeof(TerrainIndex), NULL, GL_STATIC_DRAW);
+    for (int lod = 0; lod < LOD_COUNT; ++lod) {
+        for (int mask = 0; mask < TERRAIN_EDGE_VARIANTS; ++mask) {
+            if (built[lod][mask]) {
+                glBufferSubData(GL_ELEMENT_ARRAY_BUFFER,
+                                lod_indices->offsets[lod][mask] * sizeof(TerrainIndex),
+                                lod_indices->counts[lod][mask] * sizeof(TerrainIndex),
+                                built[lod][mask]);
+            }
+            free(built[lod][mask]);
+        }
+    }
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+    lod_indices->total_count = total;
+}
+
+void terrain_lod_indices_destroy(TerrainLodIndices *lod_indices)
+{
+    if (lod_indices->buffer) {
+        glDeleteBuffers(1, &lod_indices->buffer);
+        lod_indices->buffer = 0;
+    }
+}
+
+// ---- splat mapa ----
+
+// normalizacija visine i nagib, isto kao material_weight u terrain/frag.glsl
+#define SPLAT_HEIGHT_MIN (-15.0f)
+#define SPLAT_HEIGHT_RANGE 30.0f
+
+static float smoothstepf(float edge0, float edge1, float x)
+{
+    float t = (x - edge0) / (edge1 - edge0);
+    t = t < 0.0f ? 0.0f : (t > 1.0f ? 1.0f : t);
+    return t * t * (3.0f - 2.0f * t);
+}
+
+typedef struct {
+    TerrainSplatMap *splat;
+    const Terrain *terrain;
+    int row0, col0, col1;
+} SplatBand;
+
+static void splat_rows(void *user, int begin, int end) {
+    SplatBand *band = user;
+    TerrainSplatMap *splat = band->splat;
+    int size = splat->size;
+    size_t layer_stride = (size_t)size * size * 4;
+
+    for (int row = band->row0 + begin; row < band->row0 + end; ++row) {
+        for (int col = band->col0; col < band->col1; ++col) {
+            Vertex v = terrain_grid_vertex(band->terrain, row, col);
+            float h = (v.y - SPLAT_HEIGHT_MIN) / SPLAT_HEIGHT_RANGE;
+            float slope = 1.0f - fminf(fabsf(v.ny), 1.0f);
+            float slope_bias = smoothstepf(0.35f, 0.75f, slope);
+            float flat_bias = 1.0f - slope_bias;
+
+            float weights[TERRAIN_MAX_MATERIALS] = { 0.0f };
+            float total = 0.0f;
+            for (int i = 0; i < splat->material_count; ++i) {
+                const float *b = splat->materials[i].band;
+                float weight = smoothstepf(b[0], b[1], h) - smoothstepf(b[2], b[3], h);
+                if (splat->materials[i].slope == TERRAIN_SLOPE_FLAT) {
+                    weight *= flat_bias;
+                } else if (splat->materials[i].slope == TERRAIN_SLOPE_STEEP) {
+                    weight = fmaxf(weight, slope_bias);
+                }
+                weights[i] = weight > 0.0f ? weight : 0.0f;
+                total += weights[i];
+            }
+
+            // normalizovano pre kvantizacije, shader samo mnozi
+            float inv_total = total > 0.0001f ? 1.0f / total : 0.0f;
+            unsigned char *texel = &splat->texels[((size_t)row * size + col) * 4];
+            for (int i = 0; i < splat->layers * 4; ++i) {
+                texel[(i / 4) * layer_stride + i % 4] = (unsigned char)(weights[i] * inv_total * 255.0f + 0.5f);
+            }
+        }
+    }
+}
+
+static void splat_bake(TerrainSplatMap *splat, const Terrain *terrain, int row0, int col0, int row1, int col1)
+{
+    SplatBand band = { splat, terrain, row0, col0, col1 };
+    thread_pool_parallel_for(thread_pool_shared(), row1 - row0, splat_rows, &band);
+
+    // prosiruje pravougaonik koji ceka upload
+    if (splat->dirty_row1 <= splat->dirty_row0) {
+        splat->dirty_row0 = row0;
+        splat->dirty_col0 = col0;
+        splat->dirty_row1 = row1;
+        splat->dirty_col1 = col1;
+    } else {
+        splat->dirty_row0 = row0 < splat->dirty_row0 ? row0 : splat->dirty_row0;
+        splat->dirty_col0 = col0 < splat->dirty_col0 ? col0 : splat->dirty_col0;
+        splat->dirty_row1 = row1 > splat->dirty_row1 ? row1 : splat->dirty_row1;
+        splat->dirty_col1 = col1 > splat->dirty_col1 ? col1 : splat->dirty_col1;
+    }
+}
+
+void terrain_splat_init(TerrainSplatMap *splat, const Terrain *terrain, const TerrainMaterial *materials, int material_count)
+{
+    memset(splat, 0, sizeof(*splat));
+    if (material_count > TERRAIN_MAX_MATERIALS) {
+        printf("Splat map: %d materials, at most %d supported\n", material_count, TERRAIN_MAX_MATERIALS);
+        material_count = TERRAIN_MAX_MATERIALS;
+    }
+    splat->size = terrain->size;
+    splat->materials = materials;
+    splat->material_count = material_count;
+    splat->layers = (material_count + 3) / 4;
+    splat->texels = calloc((size_t)splat->layers * splat->size * splat->size, 4);
+    if (!splat->texels) {
+        printf("Splat map: out of memory\n");
+        splat->layers = 0;
+        return;
+    }
+    splat_bake(splat, terrain, 0, 0, splat->size, splat->size);
+}
+
+void terrain_splat_update_region(TerrainSplatMap *splat, const Terrain *terrain, int row0, int col0, int row1, int col1)
+{
+    if (!splat->texels) {
+        return;
+    }
+    // normala vertexa zavisi od suseda, pa se menjaju i vertexi uz ivicu
+    row0 = clamp_to_grid(row0 - 1, splat->size);
+    col0 = clamp_to_grid(col0 - 1, splat->size);
+    row1 = clamp_to_grid(row1 + 1, splat->size);
+    col1 = clamp_to_grid(col1 + 1, splat->size);
+    if (row1 > row0 && col1 > col0) {
+        splat_bake(splat, terrain, row0, col0, row1, col1);
+    }
+}
+
+void terrain_splat_upload(TerrainSplatMap *splat)
+{
+    if (!splat->texels || splat->dirty_row1 <= splat->dirty_row0) {
+        return;
+    }
+
+    int size = splat->size;
+    if (!splat->texture) {
+        glGenTextures(1, &splat->texture);
+        glBindTexture(GL_TEXTURE_2D_ARRAY, splat->texture);
+        // jedan texel po vertexu grida, linearno izmedju njih kao sto bi interpolirao vertex shader
+        glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+        glTexImage3D(GL_TEXTURE_2D_ARRAY, 0, GL_RGBA8, size, size, splat->layers, 0, GL_RGBA, GL_UNSIGNED_BYTE, splat->texels);
+    } else {
+        int rows = splat->dirty_row1 - splat->dirty_row0;
+        int cols = splat->dirty_col1 - splat->dirty_col0;
+        glBindTexture(GL_TEXTURE_2D_ARRAY, splat->texture);
+        glPixelStorei(GL_UNPACK_ROW_LENGTH, size);
+        glPixelStorei(GL_UNPACK_IMAGE_HEIGHT, size);
+        const unsigned char *first = &splat->texels[((size_t)splat->dirty_row0 * size + splat->dirty_col0) * 4];
+        glTexSubImage3D(GL_TEXTURE_2D_ARRAY, 0, splat->dirty_col0, splat->dirty_row0, 0, cols, rows, splat->layers,
+                        GL_RGBA, GL_UNSIGNED_BYTE, first);
+        glPixelStorei(GL_UNPACK_ROW_LENGTH, 0);
+        glPixelStorei(GL_UNPACK_IMAGE_HEIGHT, 0);
+    }
+    glBindTexture(GL_TEXTURE_2D_ARRAY, 0);
+
+    splat->dirty_row0 = splat->dirty_row1 = 0;
+    splat->dirty_col0 = splat->dirty_col1 = 0;
+}
+
+void terrain_splat_destroy(TerrainSplatMap *splat)
+{
+    if (splat->texture) {
+        glDeleteTextures(1, &splat->texture);
+    }
+    free(splat->texels);
+    memset(splat, 0, sizeof(*splat));
 }
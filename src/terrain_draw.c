@@ -0,0 +1,168 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <terrain_draw.h>
+#include <GLFW/glfw3.h>
+
+typedef void (APIENTRYP TerrainMultiDrawElementsIndirectProc)(GLenum mode, GLenum type, const void *indirect,
+                                                              GLsizei draw_count, GLsizei stride);
+static TerrainMultiDrawElementsIndirectProc multi_draw_elements_indirect;
+static GLADloadproc proc_loader = (GLADloadproc)glfwGetProcAddress;
+
+void terrain_draw_set_proc_loader(GLADloadproc loader)
+{
+    proc_loader = loader;
+}
+
+static int has_extension(const char *name)
+{
+    GLint count = 0;
+    glGetIntegerv(GL_NUM_EXTENSIONS, &count);
+    for (GLint i = 0; i < count; ++i) {
+        const char *extension = (const char *)glGetStringi(GL_EXTENSIONS, i);
+        if (extension && strcmp(extension, name) == 0) {
+            return 1;
+        }
+    }
+    return 0;
+}
+
+static int indirect_supported(void)
+{
+    GLint major = 0, minor = 0;
+    glGetIntegerv(GL_MAJOR_VERSION, &major);
+    glGetIntegerv(GL_MINOR_VERSION, &minor);
+    int core = major > 4 || (major == 4 && minor >= 3);
+    if (!core && !(has_extension("GL_ARB_multi_draw_indirect") && has_extension("GL_ARB_draw_indirect"))) {
+        return 0;
+    }
+
+    multi_draw_elements_indirect = (TerrainMultiDrawElementsIndirectProc)proc_loader("glMultiDrawElementsIndirect");
+    return multi_draw_elements_indirect != NULL;
+}
+
+void terrain_draw_list_init(TerrainDrawList *list, int capacity)
+{
+    memset(list, 0, sizeof(*list));
+    list->capacity = capacity;
+    list->commands = malloc(capacity * sizeof(TerrainDrawCommand));
+    list->sort_keys = malloc(capacity * sizeof(float));
+    list->sort_items = malloc(capacity * sizeof(TerrainDrawSortItem));
+    list->sorted = malloc(capacity * sizeof(TerrainDrawCommand));
+    list->counts = malloc(capacity * sizeof(GLsizei));
+    list->offsets = malloc(capacity * sizeof(const void *));
+    list->base_vertices = malloc(capacity * sizeof(GLint));
+
+    list->path = TERRAIN_DRAW_BASE_VERTEX;
+    if (!getenv("TERRAIN_NO_INDIRECT") && indirect_supported()) {
+        list->path = TERRAIN_DRAW_INDIRECT;
+        glGenBuffers(1, &list->indirect_buffer);
+        glBindBuffer(GL_DRAW_INDIRECT_BUFFER, list->indirect_buffer);
+        glBufferData(GL_DRAW_INDIRECT_BUFFER, capacity * sizeof(TerrainDrawCommand), NULL, GL_STREAM_DRAW);
+        glBindBuffer(GL_DRAW_INDIRECT_BUFFER, 0);
+    }
+
+    printf("Terrain draw path: %s (%d commands max)\n",
+           list->path == TERRAIN_DRAW_INDIRECT ? "glMultiDrawElementsIndirect" : "glMultiDrawElementsBaseVertex",
+           capacity);
+}
+
+void terrain_draw_list_add(TerrainDrawList *list, int index_count, int first_index, int base_vertex, float sort_key)
+{
+    if (list->count >= list->capacity) {
+        return;
+    }
+    list->sort_keys[list->count] = sort_key;
+    TerrainDrawCommand *command = &list->commands[list->count++];
+    command->count = (GLuint)index_count;
+    command->instance_count = 1;
+    command->first_index = (GLuint)first_index;
+    command->base_vertex = base_vertex;
+    command->base_instance = 0;
+}
+
+static int compare_sort_items(const void *a, const void *b)
+{
+    float ka = ((const TerrainDrawSortItem *)a)->key, kb = ((const TerrainDrawSortItem *)b)->key;
+    return (ka > kb) - (ka < kb);
+}
+
+void terrain_draw_list_sort(TerrainDrawList *list)
+{
+    for (int i = 0; i < list->count; ++i) {
+        list->sort_items[i].key = list->sort_keys[i];
+        list->sort_items[i].index = i;
+    }
+    qsort(list->sort_items, list->count, sizeof(TerrainDrawSortItem), compare_sort_items);
+    for (int i = 0; i < list->count; ++i) {
+        list->sorted[i] = list->commands[list->sort_items[i].index];
+        list->sort_keys[i] = list->sort_items[i].key;
+    }
+
+    TerrainDrawCommand *swap = list->commands;
+    list->commands = list->sorted;
+    list->sorted = swap;
+}
+
+int terrain_draw_list_redraw(TerrainDrawList *list, GLenum index_type)
+{
+    if (list->count == 0) {
+        return 0;
+    }
+
+    if (list->path == TERRAIN_DRAW_INDIRECT) {
+        glBindBuffer(GL_DRAW_INDIRECT_BUFFER, list->indirect_buffer);
+        multi_draw_elements_indirect(GL_TRIANGLES, index_type, NULL, list->count, 0);
+        glBindBuffer(GL_DRAW_INDIRECT_BUFFER, 0);
+        return 1;
+    }
+
+    glMultiDrawElementsBaseVertex(GL_TRIANGLES, list->counts, index_type,
+                                  (const void *const *)list->offsets, list->count, list->base_vertices);
+    return 1;
+}
+
+int terrain_draw_list_submit(TerrainDrawList *list, GLenum index_type, size_t index_size)
+{
+    if (list->count == 0) {
+        return 0;
+    }
+
+    if (list->path == TERRAIN_DRAW_INDIRECT) {
+        // orphan pa upload, GPU moze jos da cita komande proslog frejma
+        glBindBuffer(GL_DRAW_INDIRECT_BUFFER, list->indirect_buffer);
+        glBufferData(GL_DRAW_INDIRECT_BUFFER, list->capacity * sizeof(TerrainDrawCommand), NULL, GL_STREAM_DRAW);
+        glBufferSubData(GL_DRAW_INDIRECT_BUFFER, 0, list->count * sizeof(TerrainDrawCommand), list->commands);
+        glBindBuffer(GL_DRAW_INDIRECT_BUFFER, 0);
+    } else {
+        for (int i = 0; i < list->count; ++i) {
+            list->counts[i] = (GLsizei)list->commands[i].count;
+            list->offsets[i] = (const void *)(uintptr_t)(list->commands[i].first_index * index_size);
+            list->base_vertices[i] = list->commands[i].base_vertex;
+        }
+    }
+    return terrain_draw_list_redraw(list, index_type);
+}
+
+void terrain_draw_list_destroy(TerrainDrawList *list)
+{
+    free(list->commands);
+    free(list->sort_keys);
+    free(list->sort_items);
+    free(list->sorted);
+    free(list->counts);
+    free(list->offsets);
+    free(list->base_vertices);
+    list->commands = NULL;
+    list->sort_keys = NULL;
+    list->sort_items = NULL;
+    list->sorted = NULL;
+    list->counts = NULL;
+    list->offsets = NULL;
+    list->base_vertices = NULL;
+    if (list->indirect_buffer) {
+        glDeleteBuffers(1, &list->indirect_buffer);
+        list->indirect_buffer = 0;
+    }
+}
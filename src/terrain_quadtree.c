@@ -0,0 +1,229 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <terrain_quadtree.h>
+
+typedef struct {
+    TerrainQuadtree *tree;
+    const Terrain *terrain;
+    const Frustum *frustum;
+    vec3_t camera_pos;
+} QuadSelectContext;
+
+static int build_node(TerrainQuadtree *tree, const Terrain *terrain, int patch_col, int patch_row, int level)
+{
+    if (patch_col >= terrain->patch_cols || patch_row >= terrain->patch_rows) {
+        return -1;
+    }
+
+    int index = tree->node_count++;
+    TerrainQuadNode *node = &tree->nodes[index];
+    node->col = patch_col * PATCH_SIZE;
+    node->row = patch_row * PATCH_SIZE;
+    node->level = level;
+
+    if (level == 0) {
+        const TerrainPatch *patch = &terrain->patches[patch_row * terrain->patch_cols + patch_col];
+        node->min_height = patch->min_height;
+        node->max_height = patch->max_height;
+        for (int i = 0; i < 4; ++i) {
+            node->children[i] = -1;
+        }
+        return index;
+    }
+
+    int half = 1 << (level - 1);
+    int child_cols[4] = { patch_col, patch_col + half, patch_col, patch_col + half };
+    int child_rows[4] = { patch_row, patch_row, patch_row + half, patch_row + half };
+    float min_height = INFINITY;
+    float max_height = -INFINITY;
+    for (int i = 0; i < 4; ++i) {
+        int child = build_node(tree, terrain, child_cols[i], child_rows[i], level - 1);
+        // nodes je unapred alociran pa node ostaje validan
+        node->children[i] = child;
+        if (child >= 0) {
+            min_height = fminf(min_height, tree->nodes[child].min_height);
+            max_height = fmaxf(max_height, tree->nodes[child].max_height);
+        }
+    }
+    node->min_height = min_height;
+    node->max_height = max_height;
+    return index;
+}
+
+void terrain_quadtree_build(TerrainQuadtree *tree, const Terrain *terrain, float leaf_range)
+{
+    memset(tree, 0, sizeof(*tree));
+
+    int patches_per_side = terrain->patch_cols > terrain->patch_rows ? terrain->patch_cols : terrain->patch_rows;
+    int root_level = 0;
+    while ((1 << root_level) < patches_per_side && root_level < TERRAIN_QUADTREE_MAX_LEVELS - 1) {
+        root_level++;
+    }
+    tree->levels = root_level + 1;
+
+    int capacity = 0;
+    for (int level = 0; level <= root_level; ++level) {
+        int span = 1 << level;
+        capacity += ((terrain->patch_cols + span - 1) / span) * ((terrain->patch_rows + span - 1) / span);
+    }
+    tree->nodes = malloc(capacity * sizeof(TerrainQuadNode));
+    tree->root = build_node(tree, terrain, 0, 0, root_level);
+
+    // svaki nivo vazi duplo dalje od prethodnog, a pred kraj svog opsega se
+    // vertexi pomeraju ka gridu sledeceg nivoa pa prelaz nema iskakanja
+    float previous = 0.0f;
+    for (int level = 0; level < tree->levels; ++level) {
+        float range = leaf_range * (float)(1 << level);
+        if (level == tree->levels - 1) {
+            range = 1e30f; // koren uvek pokriva ceo svet
+        }
+        tree->ranges[level] = range;
+        tree->morph_ranges[level][0] = previous + (range - previous) * TERRAIN_QUADTREE_MORPH_START;
+        tree->morph_ranges[level][1] = range;
+        previous = range;
+    }
+
+    glGenBuffers(1, &tree->draw_buffer);
+    glBindBuffer(GL_TEXTURE_BUFFER, tree->draw_buffer);
+    glBufferData(GL_TEXTURE_BUFFER, sizeof(tree->draws), NULL, GL_STREAM_DRAW);
+    glGenTextures(1, &tree->draw_texture);
+    glBindTexture(GL_TEXTURE_BUFFER, tree->draw_texture);
+    glTexBuffer(GL_TEXTURE_BUFFER, GL_RGBA32F, tree->draw_buffer);
+    glBindTexture(GL_TEXTURE_BUFFER, 0);
+    glBindBuffer(GL_TEXTURE_BUFFER, 0);
+
+    printf("Terrain quadtree: %d nodes, %d levels, leaf range %.1f\n",
+           tree->node_count, tree->levels, leaf_range);
+}
+
+static void region_bounds(const QuadSelectContext *ctx, int col, int row, int level,
+                          float min_height, float max_height, vec3_t *out_min, vec3_t *out_max)
+{
+    const Terrain *terrain = ctx->terrain;
+    float offset = (terrain->size - 1) * terrain->spacing / 2.0f;
+    float extent = (float)(PATCH_SIZE << level) * terrain->spacing;
+    float x0 = col * terrain->spacing - offset;
+    float z0 = row * terrain->spacing - offset;
+
+    float y0 = min_height * terrain->height_scale;
+    float y1 = max_height * terrain->height_scale;
+    if (y0 > y1) {
+        float tmp = y0;
+        y0 = y1;
+        y1 = tmp;
+    }
+
+    *out_min = vec3(x0, y0 - SKIRT_DEPTH, z0);
+    *out_max = vec3(x0 + extent, y1, z0 + extent);
+}
+
+static int sphere_touches_aabb(vec3_t center, float radius, vec3_t min, vec3_t max)
+{
+    float dx = fmaxf(fmaxf(min.x - center.x, 0.0f), center.x - max.x);
+    float dy = fmaxf(fmaxf(min.y - center.y, 0.0f), center.y - max.y);
+    float dz = fmaxf(fmaxf(min.z - center.z, 0.0f), center.z - max.z);
+    return dx * dx + dy * dy + dz * dz <= radius * radius;
+}
+
+static void add_draw(TerrainQuadtree *tree, int col, int row, int cell_level, int draw_level)
+{
+    if (tree->draw_count >= TERRAIN_QUADTREE_MAX_DRAWS) {
+        return;
+    }
+    TerrainQuadDraw *draw = &tree->draws[tree->draw_count++];
+    draw->col = (float)col;
+    draw->row = (float)row;
+    draw->cell_size = (float)(1 << cell_level);
+    draw->level = (float)draw_level;
+    tree->cull.drawn++;
+}
+
+// vraca 0 ako je cvor van opsega svog nivoa, tada ga roditelj crta svojim korakom
+static int select_node(const QuadSelectContext *ctx, int index, FrustumClass parent_class)
+{
+    TerrainQuadtree *tree = ctx->tree;
+    const TerrainQuadNode *node = &tree->nodes[index];
+
+    vec3_t bounds_min, bounds_max;
+    region_bounds(ctx, node->col, node->row, node->level, node->min_height, node->max_height, &bounds_min, &bounds_max);
+    if (!sphere_touches_aabb(ctx->camera_pos, tree->ranges[node->level], bounds_min, bounds_max)) {
+        return 0;
+    }
+
+    // cvor ceo unutar frustuma, deca se ne testiraju
+    FrustumClass frustum_class = parent_class;
+    if (frustum_class != FRUSTUM_INSIDE) {
+        frustum_class = frustum_classify_aabb(ctx->frustum, bounds_min, bounds_max);
+        if (frustum_class == FRUSTUM_OUTSIDE) {
+            tree->cull.culled++;
+            return 1;
+        }
+    }
+
+    if (node->level == 0 ||
+        !sphere_touches_aabb(ctx->camera_pos, tree->ranges[node->level - 1], bounds_min, bounds_max)) {
+        add_draw(tree, node->col, node->row, node->level, node->level);
+        return 1;
+    }
+
+    for (int i = 0; i < 4; ++i) {
+        int child_index = node->children[i];
+        if (child_index < 0) {
+            continue;
+        }
+        if (select_node(ctx, child_index, frustum_class)) {
+            continue;
+        }
+
+        // dete je predaleko za svoj nivo: njegova cetvrtina se crta korakom ovog cvora
+        const TerrainQuadNode *child = &tree->nodes[child_index];
+        if (frustum_class != FRUSTUM_INSIDE) {
+            vec3_t child_min, child_max;
+            region_bounds(ctx, child->col, child->row, child->level, child->min_height, child->max_height, &child_min, &child_max);
+            if (!frustum_test_aabb(ctx->frustum, child_min, child_max)) {
+                tree->cull.culled++;
+                continue;
+            }
+        }
+        add_draw(tree, child->col, child->row, child->level, node->level);
+    }
+    return 1;
+}
+
+void terrain_quadtree_select(TerrainQuadtree *tree, const Terrain *terrain, vec3_t camera_pos, const Frustum *frustum)
+{
+    tree->draw_count = 0;
+    cull_counter_reset(&tree->cull);
+    if (tree->root < 0) {
+        return;
+    }
+
+    QuadSelectContext ctx = { tree, terrain, frustum, camera_pos };
+    select_node(&ctx, tree->root, FRUSTUM_INTERSECTS);
+
+    glBindBuffer(GL_TEXTURE_BUFFER, tree->draw_buffer);
+    glBufferData(GL_TEXTURE_BUFFER, sizeof(tree->draws), NULL, GL_STREAM_DRAW);
+    glBufferSubData(GL_TEXTURE_BUFFER, 0, tree->draw_count * sizeof(TerrainQuadDraw), tree->draws);
+    glBindBuffer(GL_TEXTURE_BUFFER, 0);
+}
+
+int terrain_quadtree_draw_lod(const TerrainQuadDraw *draw)
+{
+    return (float)(1 << (int)draw->level) > draw->cell_size ? 1 : 0;
+}
+
+void terrain_quadtree_destroy(TerrainQuadtree *tree)
+{
+    free(tree->nodes);
+    tree->nodes = NULL;
+    if (tree->draw_texture) {
+        glDeleteTextures(1, &tree->draw_texture);
+        tree->draw_texture = 0;
+    }
+    if (tree->draw_buffer) {
+        glDeleteBuffers(1, &tree->draw_buffer);
+        tree->draw_buffer = 0;
+    }
+}
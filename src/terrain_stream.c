@@ -0,0 +1,322 @@
+#include <terrain_stream.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+
+// visine za chunk sa jednim redom/kolonom viska sa svake strane, da bi
+// normale na ivicama bile iste kao kod suseda
+#define CHUNK_SAMPLES (PATCH_SIZE + 3)
+
+static int wrap_window(int value)
+{
+    int m = value % STREAM_WINDOW;
+    return m < 0 ? m + STREAM_WINDOW : m;
+}
+
+static TerrainChunk *slot_for(TerrainStream *stream, int cx, int cz)
+{
+    return &stream->slots[wrap_window(cz) * STREAM_WINDOW + wrap_window(cx)];
+}
+
+static int outside_window(const TerrainStream *stream, const TerrainChunk *chunk, int radius)
+{
+    return abs(chunk->cx - stream->center_cx) > radius || abs(chunk->cz - stream->center_cz) > radius;
+}
+
+static void chunk_generate(void *user)
+{
+    TerrainChunk *chunk = user;
+    TerrainStream *stream = chunk->stream;
+    const int stride = PATCH_SIZE + 1;
+
+    float heights[CHUNK_SAMPLES * CHUNK_SAMPLES];
+    float xs[CHUNK_SAMPLES];
+    int base_col = chunk->cx * PATCH_SIZE - 1;
+    int base_row = chunk->cz * PATCH_SIZE - 1;
+
+    for (int i = 0; i < CHUNK_SAMPLES; ++i) {
+        xs[i] = (base_col + i) * stream->noise_step;
+    }
+    for (int r = 0; r < CHUNK_SAMPLES; ++r) {
+        float ny = (base_row + r) * stream->noise_step;
+        fbm_row_ctx(&stream->noise, xs, ny, CHUNK_SAMPLES, stream->octaves, &heights[r * CHUNK_SAMPLES]);
+    }
+
+    Vertex *block = malloc(PATCH_BLOCK_VERTICES * sizeof(Vertex));
+    float min_height = INFINITY;
+    float max_height = -INFINITY;
+    if (block) {
+        float hs = stream->height_scale;
+        for (int row = 0; row <= PATCH_SIZE; ++row) {
+            for (int col = 0; col <= PATCH_SIZE; ++col) {
+                const float *h = &heights[(row + 1) * CHUNK_SAMPLES + (col + 1)];
+                int world_col = base_col + 1 + col;
+                int world_row = base_row + 1 + row;
+
+                // isto kao terrain_calculate_normals
+                float nx = (h[-1] - h[1]) * hs;
+                float nz = (h[-CHUNK_SAMPLES] - h[CHUNK_SAMPLES]) * hs;
+                float ny = 2.0f * stream->spacing;
+                float length = sqrtf(nx * nx + ny * ny + nz * nz);
+                if (length > 0.0001f) {
+                    nx /= length;
+                    ny /= length;
+                    nz /= length;
+                }
+
+                float y = h[0] * hs;
+                if (y < min_height) min_height = y;
+                if (y > max_height) max_height = y;
+
+                block[row * stride + col] = vertex_create(
+                    world_col * stream->spacing, y, world_row * stream->spacing,
+                    (float)world_col / TERRAIN_DEFAULT_SIZE, (float)world_row / TERRAIN_DEFAULT_SIZE,
+                    nx, ny, nz);
+            }
+        }
+        terrain_block_build_skirts(block);
+    }
+
+    pthread_mutex_lock(&stream->mutex);
+    chunk->vertices = block;
+    chunk->min_height = min_height - SKIRT_DEPTH;
+    chunk->max_height = max_height;
+    chunk->state = block ? CHUNK_READY : CHUNK_EMPTY;
+    stream->in_flight--;
+    pthread_mutex_unlock(&stream->mutex);
+}
+
+static void chunk_upload(TerrainStream *stream, TerrainChunk *chunk)
+{
+    if (!chunk->vao) {
+        glGenVertexArrays(1, &chunk->vao);
+        glGenBuffers(1, &chunk->vbo);
+
+        glBindVertexArray(chunk->vao);
+        glBindBuffer(GL_ARRAY_BUFFER, chunk->vbo);
+        glBufferData(GL_ARRAY_BUFFER, PATCH_BLOCK_VERTICES * sizeof(Vertex), NULL, GL_DYNAMIC_DRAW);
+
+        glEnableVertexAttribArray(0);
+        glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)0);
+        glEnableVertexAttribArray(1);
+        glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)(3 * sizeof(float)));
+        glEnableVertexAttribArray(2);
+        glVertexAttribPointer(2, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)(5 * sizeof(float)));
+
+        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, stream->lod_indices.buffer);
+        glBindVertexArray(0);
+    }
+
+    // orphan pa upis, drajver ne mora da ceka crtanje starog sadrzaja slota
+    glBindBuffer(GL_ARRAY_BUFFER, chunk->vbo);
+    glBufferData(GL_ARRAY_BUFFER, PATCH_BLOCK_VERTICES * sizeof(Vertex), NULL, GL_DYNAMIC_DRAW);
+    glBufferSubData(GL_ARRAY_BUFFER, 0, PATCH_BLOCK_VERTICES * sizeof(Vertex), chunk->vertices);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+    free(chunk->vertices);
+    chunk->vertices = NULL;
+    chunk->state = CHUNK_RESIDENT;
+}
+
+void terrain_stream_init(TerrainStream *stream, uint32_t seed, float spacing, float height_scale)
+{
+    memset(stream, 0, sizeof(*stream));
+    noise_context_init(&stream->noise, seed);
+    stream->spacing = spacing;
+    stream->height_scale = height_scale;
+    stream->noise_step = TERRAIN_NOISE_SCALE / TERRAIN_DEFAULT_SIZE;
+    stream->octaves = TERRAIN_NOISE_OCTAVES;
+    stream->pool = thread_pool_shared();
+    stream->upload_budget_bytes = STREAM_UPLOAD_BUDGET_BYTES;
+    pthread_mutex_init(&stream->mutex, NULL);
+
+    for (int i = 0; i < STREAM_SLOT_COUNT; ++i) {
+        stream->slots[i].stream = stream;
+        stream->slots[i].state = CHUNK_EMPTY;
+    }
+
+    // indeksi su lokalni za blok pa svi chunkovi dele isti buffer
+    terrain_lod_indices_create(&stream->lod_indices);
+
+    printf("Terrain stream initialized: %d slots, view radius %d chunks, seed %u\n",
+           STREAM_SLOT_COUNT, STREAM_VIEW_RADIUS, seed);
+}
+
+void terrain_stream_update(TerrainStream *stream, vec3_t camera_pos)
+{
+    float chunk_world = PATCH_SIZE * stream->spacing;
+    stream->center_cx = (int)floorf(camera_pos.x / chunk_world);
+    stream->center_cz = (int)floorf(camera_pos.z / chunk_world);
+
+    TerrainChunk *ready[STREAM_SLOT_COUNT];
+    int ready_count = 0;
+    int resident = 0;
+
+    pthread_mutex_lock(&stream->mutex);
+
+    // izbacivanje chunkova van prozora (GENERATING ceka da se zavrsi)
+    for (int i = 0; i < STREAM_SLOT_COUNT; ++i) {
+        TerrainChunk *chunk = &stream->slots[i];
+        if (chunk->state == CHUNK_EMPTY || chunk->state == CHUNK_GENERATING) {
+            continue;
+        }
+        if (outside_window(stream, chunk, STREAM_EVICT_RADIUS)) {
+            free(chunk->vertices);
+            chunk->vertices = NULL;
+            chunk->state = CHUNK_EMPTY;
+            continue;
+        }
+        if (chunk->state == CHUNK_READY) {
+            ready[ready_count++] = chunk;
+        } else {
+            resident++;
+        }
+    }
+
+    // novi chunkovi, od kamere ka spolja da bi bliski stigli prvi
+    // (bez worker niti submit radi odmah, pa je broj po frejmu ogranicen)
+    int submitted = 0;
+    for (int ring = 0; ring <= STREAM_VIEW_RADIUS && submitted < STREAM_MAX_IN_FLIGHT; ++ring) {
+        for (int dz = -ring; dz <= ring && submitted < STREAM_MAX_IN_FLIGHT; ++dz) {
+            for (int dx = -ring; dx <= ring; ++dx) {
+                if (abs(dx) != ring && abs(dz) != ring) {
+                    continue;
+                }
+                int cx = stream->center_cx + dx;
+                int cz = stream->center_cz + dz;
+                TerrainChunk *chunk = slot_for(stream, cx, cz);
+                if (chunk->state != CHUNK_EMPTY) {
+                    continue;
+                }
+
+                chunk->cx = cx;
+                chunk->cz = cz;
+                chunk->state = CHUNK_GENERATING;
+                stream->in_flight++;
+                submitted++;
+
+                pthread_mutex_unlock(&stream->mutex);
+                thread_pool_submit(stream->pool, &stream->jobs, chunk_generate, chunk);
+                pthread_mutex_lock(&stream->mutex);
+
+                if (stream->in_flight >= STREAM_MAX_IN_FLIGHT || submitted >= STREAM_MAX_IN_FLIGHT) {
+                    submitted = STREAM_MAX_IN_FLIGHT;
+                    break;
+                }
+            }
+        }
+    }
+
+    pthread_mutex_unlock(&stream->mutex);
+
+    // READY chunkove worker vise ne dira, upload ide bez mutexa
+    int budget = stream->upload_budget_bytes;
+    int uploads = 0;
+    for (int i = 0; i < ready_count; ++i) {
+        int bytes = PATCH_BLOCK_VERTICES * (int)sizeof(Vertex);
+        if (uploads > 0 && budget < bytes) {
+            break;
+        }
+        chunk_upload(stream, ready[i]);
+        budget -= bytes;
+        uploads++;
+    }
+
+    stream->uploads_last_frame = uploads;
+    stream->resident_count = resident + uploads;
+}
+
+// zavisi samo od koordinata pa se moze racunati i za susede koji nisu ucitani;
+// susedni chunkovi su blizi od razmaka izmedju pragova pa se LOD razlikuje najvise za jedan
+static int chunk_lod(const TerrainStream *stream, int cx, int cz, vec3_t camera_pos)
+{
+    float chunk_world = PATCH_SIZE * stream->spacing;
+    float dx = camera_pos.x - (cx + 0.5f) * chunk_world;
+    float dz = camera_pos.z - (cz + 0.5f) * chunk_world;
+    return terrain_lod_for_distance(sqrtf(dx * dx + dz * dz));
+}
+
+typedef struct {
+    float distance_sq;
+    int slot;
+    int lod;
+    int edge_mask;
+} ChunkDraw;
+
+static int compare_chunk_draws(const void *a, const void *b)
+{
+    float da = ((const ChunkDraw *)a)->distance_sq, db = ((const ChunkDraw *)b)->distance_sq;
+    return (da > db) - (da < db);
+}
+
+void terrain_stream_render(TerrainStream *stream, vec3_t camera_pos, const Frustum *frustum)
+{
+    float chunk_world = PATCH_SIZE * stream->spacing;
+    cull_counter_reset(&stream->cull);
+    stream->triangles = 0;
+
+    ChunkDraw draws[STREAM_SLOT_COUNT];
+    int draw_count = 0;
+    for (int i = 0; i < STREAM_SLOT_COUNT; ++i) {
+        TerrainChunk *chunk = &stream->slots[i];
+        if (chunk->state != CHUNK_RESIDENT || outside_window(stream, chunk, STREAM_VIEW_RADIUS)) {
+            continue;
+        }
+
+        vec3_t bounds_min = vec3(chunk->cx * chunk_world, chunk->min_height, chunk->cz * chunk_world);
+        vec3_t bounds_max = vec3((chunk->cx + 1) * chunk_world, chunk->max_height, (chunk->cz + 1) * chunk_world);
+        if (!frustum_test_aabb(frustum, bounds_min, bounds_max)) {
+            stream->cull.culled++;
+            continue;
+        }
+
+        int lod = chunk_lod(stream, chunk->cx, chunk->cz, camera_pos);
+        int edge_mask = 0;
+        if (chunk_lod(stream, chunk->cx, chunk->cz - 1, camera_pos) > lod) edge_mask |= TERRAIN_EDGE_TOP;
+        if (chunk_lod(stream, chunk->cx + 1, chunk->cz, camera_pos) > lod) edge_mask |= TERRAIN_EDGE_RIGHT;
+        if (chunk_lod(stream, chunk->cx, chunk->cz + 1, camera_pos) > lod) edge_mask |= TERRAIN_EDGE_BOTTOM;
+        if (chunk_lod(stream, chunk->cx - 1, chunk->cz, camera_pos) > lod) edge_mask |= TERRAIN_EDGE_LEFT;
+
+        vec3_t center = v3_muls(v3_add(bounds_min, bounds_max), 0.5f);
+        vec3_t to_camera = v3_sub(center, camera_pos);
+        draws[draw_count].distance_sq = v3_dot(to_camera, to_camera);
+        draws[draw_count].slot = i;
+        draws[draw_count].lod = lod;
+        draws[draw_count].edge_mask = edge_mask;
+        draw_count++;
+    }
+
+    // napred ka nazad, kao terrain_draw_list_sort za fiksni teren
+    qsort(draws, draw_count, sizeof(ChunkDraw), compare_chunk_draws);
+    for (int i = 0; i < draw_count; ++i) {
+        const ChunkDraw *draw = &draws[i];
+        glBindVertexArray(stream->slots[draw->slot].vao);
+        glDrawElements(GL_TRIANGLES, stream->lod_indices.counts[draw->lod][draw->edge_mask], TERRAIN_INDEX_GL_TYPE,
+                       (void*)(stream->lod_indices.offsets[draw->lod][draw->edge_mask] * sizeof(TerrainIndex)));
+        stream->cull.drawn++;
+        stream->triangles += stream->lod_indices.counts[draw->lod][draw->edge_mask] / 3;
+    }
+    glBindVertexArray(0);
+}
+
+void terrain_stream_cleanup(TerrainStream *stream)
+{
+    // workeri jos mogu da pisu u slotove
+    thread_pool_wait(stream->pool, &stream->jobs);
+
+    for (int i = 0; i < STREAM_SLOT_COUNT; ++i) {
+        TerrainChunk *chunk = &stream->slots[i];
+        free(chunk->vertices);
+        chunk->vertices = NULL;
+        if (chunk->vao) {
+            glDeleteVertexArrays(1, &chunk->vao);
+            glDeleteBuffers(1, &chunk->vbo);
+            chunk->vao = 0;
+            chunk->vbo = 0;
+        }
+        chunk->state = CHUNK_EMPTY;
+    }
+
+    terrain_lod_indices_destroy(&stream->lod_indices);
+    pthread_mutex_destroy(&stream->mutex);
+}
@@ -1,76 +1,210 @@
 #include <stdio.h>
+#include <stdlib.h>
 #include <glad/glad.h>
 
 #include <stb_image.h>
 
 #include <texture.h>
 
-GLuint texture_load(const char *filepath) {
-    int width, height, channels;
-    unsigned char *data = stbi_load(filepath, &width, &height, &channels, 0);
-    if (!data) {
-        printf("Failed to load texture: %s\n", filepath);
-        return 0;
+GLenum texture_pixel_format(int channels) {
+    switch (channels) {
+        case 1: return GL_RED;
+        case 2: return GL_RG;
+        case 3: return GL_RGB;
+        default: return GL_RGBA;
+    }
+}
+
+int texture_mip_level_count(int width, int height) {
+    int levels = 1;
+    while ((width > 1 || height > 1) && levels < TEXTURE_BC_MAX_LEVELS) {
+        width = width > 1 ? width / 2 : 1;
+        height = height > 1 ? height / 2 : 1;
+        levels++;
+    }
+    return levels;
+}
+
+int texture_bc_faces_usable(const TextureBcImage *faces, int count) {
+    for (int i = 0; i < count; ++i) {
+        if (!faces[i].data || faces[i].header.format != faces[0].header.format ||
+            faces[i].header.width != faces[0].header.width || faces[i].header.height != faces[0].header.height ||
+            faces[i].header.level_count != faces[0].header.level_count) {
+            return 0;
+        }
+    }
+    return count > 0;
+}
+
+int texture_faces_match(const int *widths, const int *heights, const int *channels, int count) {
+    for (int i = 1; i < count; ++i) {
+        if (widths[i] != widths[0] || heights[i] != heights[0] || channels[i] != channels[0]) {
+            return 0;
+        }
     }
-    
+    return 1;
+}
+
+GLuint texture_storage_create(GLenum target, uint32_t bc_format, int channels, int width, int height, int faces, int level_count) {
+    GLenum compressed_format = texture_bc_gl_format(bc_format);
+    GLenum format = texture_pixel_format(channels);
+
     GLuint tex_id;
     glGenTextures(1, &tex_id);
-    glBindTexture(GL_TEXTURE_2D, tex_id);
-    
-    // wrap
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
-    
-    // filteri
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-    
-    
-    GLenum format = (channels == 4) ? GL_RGBA : GL_RGB;
-    
-    glTexImage2D(GL_TEXTURE_2D, 0, format, width, height, 0, format, GL_UNSIGNED_BYTE, data);
-    glGenerateMipmap(GL_TEXTURE_2D);
-    
-    stbi_image_free(data);
-    
+    glBindTexture(target, tex_id);
+    // niz: jedan storage po nivou za sve slojeve
+    int storage_faces = target == GL_TEXTURE_2D_ARRAY ? 1 : faces;
+    for (int face = 0; face < storage_faces; ++face) {
+        GLenum face_target = target == GL_TEXTURE_CUBE_MAP ? GL_TEXTURE_CUBE_MAP_POSITIVE_X + face : target;
+        for (int level = 0; level < level_count; ++level) {
+            int w = width >> level, h = height >> level;
+            w = w > 0 ? w : 1;
+            h = h > 0 ? h : 1;
+            GLsizei size = (GLsizei)texture_bc_level_size(bc_format, w, h);
+            if (target == GL_TEXTURE_2D_ARRAY && compressed_format) {
+                glCompressedTexImage3D(face_target, level, compressed_format, w, h, faces, 0, size * faces, NULL);
+            } else if (target == GL_TEXTURE_2D_ARRAY) {
+                glTexImage3D(face_target, level, format, w, h, faces, 0, format, GL_UNSIGNED_BYTE, NULL);
+            } else if (compressed_format) {
+                glCompressedTexImage2D(face_target, level, compressed_format, w, h, 0, size, NULL);
+            } else {
+                glTexImage2D(face_target, level, format, w, h, 0, format, GL_UNSIGNED_BYTE, NULL);
+            }
+        }
+    }
+    glTexParameteri(target, GL_TEXTURE_MAX_LEVEL, level_count - 1);
+    if (target != GL_TEXTURE_CUBE_MAP) {
+        glTexParameteri(target, GL_TEXTURE_WRAP_S, GL_REPEAT);
+        glTexParameteri(target, GL_TEXTURE_WRAP_T, GL_REPEAT);
+        glTexParameteri(target, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+        glTexParameteri(target, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    } else {
+        glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_R, GL_CLAMP_TO_EDGE);
+    }
     return tex_id;
 }
 
-GLuint texture_load_cubemap(const char **faces, int count)
-{
-    if(count != 6)
-    {
-        printf("Cubemap requires 6 faces, got %d\n", count);
-        return 0;
+void texture_upload_rows(GLenum target, int face, int level, int y, int width, int height,
+                         uint32_t bc_format, int channels, GLsizei bytes, const void *data) {
+    GLenum face_target = target == GL_TEXTURE_CUBE_MAP ? GL_TEXTURE_CUBE_MAP_POSITIVE_X + face : target;
+    GLenum compressed_format = texture_bc_gl_format(bc_format);
+    GLenum format = texture_pixel_format(channels);
+    if (target == GL_TEXTURE_2D_ARRAY && compressed_format) {
+        glCompressedTexSubImage3D(face_target, level, 0, y, face, width, height, 1, compressed_format, bytes, data);
+    } else if (target == GL_TEXTURE_2D_ARRAY) {
+        glTexSubImage3D(face_target, level, 0, y, face, width, height, 1, format, GL_UNSIGNED_BYTE, data);
+    } else if (compressed_format) {
+        glCompressedTexSubImage2D(face_target, level, 0, y, width, height, compressed_format, bytes, data);
+    } else {
+        glTexSubImage2D(face_target, level, 0, y, width, height, format, GL_UNSIGNED_BYTE, data);
+    }
+}
+
+// sve strane/slojevi iz PNG-ova; mipove pravi drajver, cubemap se filtrira sa GL_LINEAR pa mu ne trebaju
+static GLuint texture_load_png_faces(GLenum target, const char **paths, int count) {
+    unsigned char **pixels = calloc(count, sizeof(*pixels));
+    int *sizes = calloc(3 * count, sizeof(*sizes));
+    int *widths = sizes, *heights = sizes + count, *channels = sizes + 2 * count;
+    int loaded = 0;
+    while (pixels && sizes && loaded < count) {
+        pixels[loaded] = stbi_load(paths[loaded], &widths[loaded], &heights[loaded], &channels[loaded], 0);
+        if (!pixels[loaded]) {
+            printf("Failed to load texture: %s\n", paths[loaded]);
+            break;
+        }
+        loaded++;
     }
 
-    GLuint texture_id = 0;
-    glGenTextures(1, &texture_id);
-    glBindTexture(GL_TEXTURE_CUBE_MAP, texture_id);
+    GLuint tex_id = 0;
+    if (loaded == count && !texture_faces_match(widths, heights, channels, count)) {
+        printf("Texture faces/layers of %s differ in size or channels\n", paths[0]);
+    } else if (loaded == count) {
+        int level_count = target != GL_TEXTURE_CUBE_MAP ? texture_mip_level_count(widths[0], heights[0]) : 1;
+        tex_id = texture_storage_create(target, 0, channels[0], widths[0], heights[0], count, level_count);
+        // stbi redovi nisu poravnati na 4 bajta za 1-3 kanala
+        glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+        for (int i = 0; i < count; ++i) {
+            texture_upload_rows(target, i, 0, 0, widths[0], heights[0], 0, channels[0],
+                                widths[0] * heights[0] * channels[0], pixels[i]);
+        }
+        glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+        if (level_count > 1) {
+            glGenerateMipmap(target);
+        }
+        glBindTexture(target, 0);
+    }
 
+    for (int i = 0; i < loaded; ++i) {
+        stbi_image_free(pixels[i]);
+    }
+    free(pixels);
+    free(sizes);
+    return tex_id;
+}
 
-    for(int i = 0; i < count; ++i)
-    {
-        int width = 0, height = 0, channels = 0;
-        unsigned char *data = stbi_load(faces[i], &width, &height, &channels, 0);
-        if(!data)
-        {
-            printf("Failed to load cubemap face: %s\n", faces[i]);
-            glDeleteTextures(1, &texture_id);
-            return 0;
+// sve strane/slojevi iz .rtex-a; 0 ako neka nije pecena ili se razlikuju, pa ide ceo PNG put
+static GLuint texture_load_bc_faces(GLenum target, const char **paths, int count) {
+    if (!texture_bc_supported()) {
+        return 0;
+    }
+    TextureBcImage *faces = calloc(count, sizeof(*faces));
+    int read = 0;
+    while (faces && read < count && texture_bc_read(&faces[read], paths[read]) == 0) {
+        read++;
+    }
+
+    GLuint tex_id = 0;
+    if (read == count && texture_bc_faces_usable(faces, count)) {
+        const TextureBcHeader *header = &faces[0].header;
+        // mipovi su vec u fajlu; cubemap se filtrira sa GL_LINEAR, dovoljan je nivo 0
+        int level_count = target != GL_TEXTURE_CUBE_MAP ? texture_mip_level_count(header->width, header->height) : 1;
+        if (level_count > (int)header->level_count) {
+            level_count = header->level_count;
         }
+        tex_id = texture_storage_create(target, header->format, 0, header->width, header->height, count, level_count);
+        for (int i = 0; i < count; ++i) {
+            for (int level = 0; level < level_count; ++level) {
+                int w = header->width >> level, h = header->height >> level;
+                texture_upload_rows(target, i, level, 0, w > 0 ? w : 1, h > 0 ? h : 1, header->format, 0,
+                                    faces[i].header.level_sizes[level], faces[i].levels[level]);
+            }
+        }
+        glBindTexture(target, 0);
+    }
 
-        GLenum format = (channels == 4) ? GL_RGBA : GL_RGB;
-        glTexImage2D(GL_TEXTURE_CUBE_MAP_POSITIVE_X + i, 0, format, width, height, 0, format, GL_UNSIGNED_BYTE, data);
-        stbi_image_free(data);
+    for (int i = 0; i < read; ++i) {
+        texture_bc_free(&faces[i]);
     }
+    free(faces);
+    return tex_id;
+}
 
-    glGenerateMipmap(GL_TEXTURE_CUBE_MAP);
-    glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-    glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-    glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
-    glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
-    glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_R, GL_CLAMP_TO_EDGE);
+static GLuint texture_load_faces(GLenum target, const char **paths, int count) {
+    GLuint tex_id = texture_load_bc_faces(target, paths, count);
+    return tex_id ? tex_id : texture_load_png_faces(target, paths, count);
+}
+
+GLuint texture_load(const char *filepath) {
+    return texture_load_faces(GL_TEXTURE_2D, &filepath, 1);
+}
 
-    return texture_id;
+GLuint texture_load_cubemap(const char **faces, int count)
+{
+    if(count != 6)
+    {
+        printf("Cubemap requires 6 faces, got %d\n", count);
+        return 0;
+    }
+    return texture_load_faces(GL_TEXTURE_CUBE_MAP, faces, count);
+}
+
+GLuint texture_load_array(const char **paths, int count) {
+    if (count <= 0) {
+        return 0;
+    }
+    return texture_load_faces(GL_TEXTURE_2D_ARRAY, paths, count);
 }
@@ -0,0 +1,455 @@
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+
+#include <stb_image.h>
+#include <texture_bc.h>
+
+GLenum texture_bc_gl_format(uint32_t format)
+{
+    switch (format) {
+        case TEXTURE_BC1: return GL_COMPRESSED_RGB_S3TC_DXT1_EXT;
+        case TEXTURE_BC3: return GL_COMPRESSED_RGBA_S3TC_DXT5_EXT;
+        case TEXTURE_BC5: return GL_COMPRESSED_RG_RGTC2;
+        default: return 0;
+    }
+}
+
+int texture_bc_block_bytes(uint32_t format)
+{
+    return format == TEXTURE_BC1 ? 8 : 16;
+}
+
+size_t texture_bc_level_size(uint32_t format, int width, int height)
+{
+    return (size_t)((width + 3) / 4) * ((height + 3) / 4) * texture_bc_block_bytes(format);
+}
+
+int texture_bc_supported(void)
+{
+    const char *disabled = getenv("TERRAIN_NO_BC");
+    if (disabled && atoi(disabled) != 0) {
+        return 0;
+    }
+
+    // core profil: lista ekstenzija samo preko glGetStringi
+    GLint count = 0;
+    glGetIntegerv(GL_NUM_EXTENSIONS, &count);
+    for (GLint i = 0; i < count; ++i) {
+        const char *name = (const char *)glGetStringi(GL_EXTENSIONS, i);
+        if (name && strcmp(name, "GL_EXT_texture_compression_s3tc") == 0) {
+            return 1;
+        }
+    }
+    return 0;
+}
+
+static int source_info(const char *path, uint64_t *mtime, uint64_t *size)
+{
+    struct stat st;
+    if (stat(path, &st) != 0) {
+        return -1;
+    }
+    *mtime = (uint64_t)st.st_mtime;
+    *size = (uint64_t)st.st_size;
+    return 0;
+}
+
+// ---- enkoder ----
+
+static uint16_t pack_565(const int rgb[3])
+{
+    int r = (rgb[0] * 31 + 127) / 255;
+    int g = (rgb[1] * 63 + 127) / 255;
+    int b = (rgb[2] * 31 + 127) / 255;
+    return (uint16_t)((r << 11) | (g << 5) | b);
+}
+
+static void unpack_565(uint16_t color, int rgb[3])
+{
+    int r = (color >> 11) & 31, g = (color >> 5) & 63, b = color & 31;
+    rgb[0] = (r << 3) | (r >> 2);
+    rgb[1] = (g << 2) | (g >> 4);
+    rgb[2] = (b << 3) | (b >> 2);
+}
+
+static void write_u16(unsigned char *out, uint16_t value)
+{
+    out[0] = (unsigned char)(value & 0xFF);
+    out[1] = (unsigned char)(value >> 8);
+}
+
+// krajnje boje su pikseli sa min i max projekcijom na glavnu osu boja bloka,
+// pomereni 1/16 ka sredini da greska ne ide samo na jednu stranu
+static void encode_bc1(const unsigned char block[16][4], unsigned char out[8])
+{
+    float mean[3] = { 0.0f, 0.0f, 0.0f };
+    for (int i = 0; i < 16; ++i) {
+        for (int c = 0; c < 3; ++c) {
+            mean[c] += block[i][c] / 16.0f;
+        }
+    }
+
+    float cov[3][3] = { { 0.0f } };
+    for (int i = 0; i < 16; ++i) {
+        float d[3] = { block[i][0] - mean[0], block[i][1] - mean[1], block[i][2] - mean[2] };
+        for (int a = 0; a < 3; ++a) {
+            for (int b = 0; b < 3; ++b) {
+                cov[a][b] += d[a] * d[b];
+            }
+        }
+    }
+
+    // power iteracija, par koraka je dovoljno za 16 piksela
+    float axis[3] = { 1.0f, 1.0f, 1.0f };
+    for (int iteration = 0; iteration < 4; ++iteration) {
+        float next[3];
+        float length = 0.0f;
+        for (int a = 0; a < 3; ++a) {
+            next[a] = cov[a][0] * axis[0] + cov[a][1] * axis[1] + cov[a][2] * axis[2];
+            length = next[a] * next[a] > length ? next[a] * next[a] : length;
+        }
+        if (length < 1e-6f) {
+            break;
+        }
+        for (int a = 0; a < 3; ++a) {
+            axis[a] = next[a];
+        }
+        float largest = fabsf(axis[0]) > fabsf(axis[1]) ? fabsf(axis[0]) : fabsf(axis[1]);
+        largest = largest > fabsf(axis[2]) ? largest : fabsf(axis[2]);
+        for (int a = 0; a < 3; ++a) {
+            axis[a] /= largest;
+        }
+    }
+
+    int lo = 0, hi = 0;
+    float lo_dot = 1e30f, hi_dot = -1e30f;
+    for (int i = 0; i < 16; ++i) {
+        float dot = block[i][0] * axis[0] + block[i][1] * axis[1] + block[i][2] * axis[2];
+        if (dot < lo_dot) {
+            lo_dot = dot;
+            lo = i;
+        }
+        if (dot > hi_dot) {
+            hi_dot = dot;
+            hi = i;
+        }
+    }
+
+    int max_rgb[3], min_rgb[3];
+    for (int c = 0; c < 3; ++c) {
+        int inset = (block[hi][c] - block[lo][c]) / 16;
+        max_rgb[c] = block[hi][c] - inset;
+        min_rgb[c] = block[lo][c] + inset;
+        max_rgb[c] = max_rgb[c] < 0 ? 0 : (max_rgb[c] > 255 ? 255 : max_rgb[c]);
+        min_rgb[c] = min_rgb[c] < 0 ? 0 : (min_rgb[c] > 255 ? 255 : min_rgb[c]);
+    }
+
+    uint16_t c0 = pack_565(max_rgb), c1 = pack_565(min_rgb);
+    if (c0 < c1) {
+        uint16_t swap = c0;
+        c0 = c1;
+        c1 = swap;
+    }
+    write_u16(out, c0);
+    write_u16(out + 2, c1);
+
+    // c0 == c1: jednobojan blok, svi indeksi 0
+    uint32_t indices = 0;
+    if (c0 != c1) {
+        int palette[4][3];
+        unpack_565(c0, palette[0]);
+        unpack_565(c1, palette[1]);
+        for (int c = 0; c < 3; ++c) {
+            palette[2][c] = (2 * palette[0][c] + palette[1][c] + 1) / 3;
+            palette[3][c] = (palette[0][c] + 2 * palette[1][c] + 1) / 3;
+        }
+        for (int i = 0; i < 16; ++i) {
+            int best = 0, best_error = 1 << 30;
+            for (int p = 0; p < 4; ++p) {
+                int dr = block[i][0] - palette[p][0], dg = block[i][1] - palette[p][1], db = block[i][2] - palette[p][2];
+                int error = dr * dr + dg * dg + db * db;
+                if (error < best_error) {
+                    best_error = error;
+                    best = p;
+                }
+            }
+            indices |= (uint32_t)best << (2 * i);
+        }
+    }
+    for (int i = 0; i < 4; ++i) {
+        out[4 + i] = (unsigned char)(indices >> (8 * i));
+    }
+}
+
+// jedan kanal (BC3 alfa, BC5 r i g): min i max, izmedju njih 6 interpolisanih vrednosti
+static void encode_bc4(const unsigned char block[16][4], int channel, unsigned char out[8])
+{
+    int lo = 255, hi = 0;
+    for (int i = 0; i < 16; ++i) {
+        int value = block[i][channel];
+        lo = value < lo ? value : lo;
+        hi = value > hi ? value : hi;
+    }
+    out[0] = (unsigned char)hi;
+    out[1] = (unsigned char)lo;
+
+    uint64_t indices = 0;
+    if (hi != lo) {
+        // a0 > a1: 0 = a0, 1 = a1, 2..7 = ((8 - i) * a0 + (i - 1) * a1) / 7
+        int palette[8];
+        palette[0] = hi;
+        palette[1] = lo;
+        for (int i = 2; i < 8; ++i) {
+            palette[i] = ((8 - i) * hi + (i - 1) * lo + 3) / 7;
+        }
+        for (int i = 0; i < 16; ++i) {
+            int best = 0, best_error = 256;
+            for (int p = 0; p < 8; ++p) {
+                int error = abs(block[i][channel] - palette[p]);
+                if (error < best_error) {
+                    best_error = error;
+                    best = p;
+                }
+            }
+            indices |= (uint64_t)best << (3 * i);
+        }
+    }
+    for (int i = 0; i < 6; ++i) {
+        out[2 + i] = (unsigned char)(indices >> (8 * i));
+    }
+}
+
+static void encode_level(const unsigned char *rgba, int width, int height, uint32_t format, unsigned char *out)
+{
+    int block_bytes = texture_bc_block_bytes(format);
+    for (int by = 0; by < height; by += 4) {
+        for (int bx = 0; bx < width; bx += 4) {
+            // nivoi manji od 4x4 ponavljaju ivicne piksele
+            unsigned char block[16][4];
+            for (int y = 0; y < 4; ++y) {
+                int sy = by + y < height ? by + y : height - 1;
+                for (int x = 0; x < 4; ++x) {
+                    int sx = bx + x < width ? bx + x : width - 1;
+                    memcpy(block[y * 4 + x], rgba + ((size_t)sy * width + sx) * 4, 4);
+                }
+            }
+
+            switch (format) {
+                case TEXTURE_BC1:
+                    encode_bc1(block, out);
+                    break;
+                case TEXTURE_BC3:
+                    encode_bc4(block, 3, out);
+                    encode_bc1(block, out + 8);
+                    break;
+                case TEXTURE_BC5:
+                    encode_bc4(block, 0, out);
+                    encode_bc4(block, 1, out + 8);
+                    break;
+            }
+            out += block_bytes;
+        }
+    }
+}
+
+// 2x2 box filter, isti kao u texture_stream.c
+static unsigned char *downsample_rgba(const unsigned char *src, int width, int height)
+{
+    int dst_width = width > 1 ? width / 2 : 1;
+    int dst_height = height > 1 ? height / 2 : 1;
+    unsigned char *dst = malloc((size_t)dst_width * dst_height * 4);
+    if (!dst) {
+        return NULL;
+    }
+
+    for (int y = 0; y < dst_height; ++y) {
+        int y0 = y * 2;
+        int y1 = y0 + 1 < height ? y0 + 1 : y0;
+        for (int x = 0; x < dst_width; ++x) {
+            int x0 = x * 2;
+            int x1 = x0 + 1 < width ? x0 + 1 : x0;
+            for (int c = 0; c < 4; ++c) {
+                int sum = src[(y0 * width + x0) * 4 + c] + src[(y0 * width + x1) * 4 + c] +
+                          src[(y1 * width + x0) * 4 + c] + src[(y1 * width + x1) * 4 + c];
+                dst[(y * dst_width + x) * 4 + c] = (unsigned char)((sum + 2) / 4);
+            }
+        }
+    }
+    return dst;
+}
+
+static TextureBcFormat choose_format(const unsigned char *rgba, int width, int height, int channels)
+{
+    if (channels == 2) {
+        return TEXTURE_BC5;
+    }
+    if (channels == 4) {
+        for (size_t i = 0; i < (size_t)width * height; ++i) {
+            if (rgba[i * 4 + 3] != 255) {
+                return TEXTURE_BC3;
+            }
+        }
+    }
+    return TEXTURE_BC1;
+}
+
+int texture_bc_bake(const char *png_path, const char *output_path, TextureBcFormat format)
+{
+    TextureBcHeader header;
+    memset(&header, 0, sizeof(header));
+    if (source_info(png_path, &header.source_mtime, &header.source_size) != 0) {
+        printf("Failed to stat texture: %s\n", png_path);
+        return -1;
+    }
+
+    int width = 0, height = 0, channels = 0;
+    unsigned char *pixels = stbi_load(png_path, &width, &height, &channels, 4);
+    if (!pixels) {
+        printf("Failed to load texture: %s\n", png_path);
+        return -1;
+    }
+    // sivi PNG ide kroz BC1 kao RGB, dvokanalni se cita kao (siva, alfa) -> r, g za BC5
+    if (channels == 2) {
+        for (size_t i = 0; i < (size_t)width * height; ++i) {
+            pixels[i * 4 + 1] = pixels[i * 4 + 3];
+        }
+    }
+    if (format == TEXTURE_BC_AUTO) {
+        format = choose_format(pixels, width, height, channels);
+    }
+
+    memcpy(header.magic, TEXTURE_BC_MAGIC, 4);
+    header.version = TEXTURE_BC_VERSION;
+    header.format = format;
+    header.width = width;
+    header.height = height;
+
+    FILE *file = fopen(output_path, "wb");
+    if (!file) {
+        printf("Failed to open %s for writing\n", output_path);
+        stbi_image_free(pixels);
+        return -1;
+    }
+    // zaglavlje se prepisuje na kraju, kad su velicine nivoa poznate
+    int ok = fwrite(&header, sizeof(header), 1, file) == 1;
+
+    unsigned char *level = pixels;
+    int w = width, h = height;
+    while (ok && header.level_count < TEXTURE_BC_MAX_LEVELS) {
+        size_t size = texture_bc_level_size(format, w, h);
+        unsigned char *blocks = malloc(size);
+        ok = blocks != NULL;
+        if (ok) {
+            encode_level(level, w, h, format, blocks);
+            ok = fwrite(blocks, 1, size, file) == size;
+            free(blocks);
+        }
+        header.level_sizes[header.level_count++] = (uint32_t)size;
+
+        if (w == 1 && h == 1) {
+            break;
+        }
+        unsigned char *next = downsample_rgba(level, w, h);
+        if (level != pixels) {
+            free(level);
+        }
+        level = next;
+        ok = ok && level != NULL;
+        w = w > 1 ? w / 2 : 1;
+        h = h > 1 ? h / 2 : 1;
+    }
+    if (level != pixels) {
+        free(level);
+    }
+    stbi_image_free(pixels);
+
+    ok = ok && fseek(file, 0, SEEK_SET) == 0 && fwrite(&header, sizeof(header), 1, file) == 1;
+    ok = fclose(file) == 0 && ok;
+    if (!ok) {
+        printf("Failed to write %s\n", output_path);
+        remove(output_path);
+        return -1;
+    }
+    return 0;
+}
+
+// ---- citanje ----
+
+static int header_valid(const TextureBcHeader *header, long file_size)
+{
+    if (memcmp(header->magic, TEXTURE_BC_MAGIC, 4) != 0 || header->version != TEXTURE_BC_VERSION) {
+        return 0;
+    }
+    if (texture_bc_gl_format(header->format) == 0 || header->width == 0 || header->height == 0 ||
+        header->level_count == 0 || header->level_count > TEXTURE_BC_MAX_LEVELS) {
+        return 0;
+    }
+
+    size_t expected = sizeof(*header);
+    for (uint32_t level = 0; level < header->level_count; ++level) {
+        int w = header->width >> level, h = header->height >> level;
+        if (header->level_sizes[level] != texture_bc_level_size(header->format, w > 0 ? w : 1, h > 0 ? h : 1)) {
+            return 0;
+        }
+        expected += header->level_sizes[level];
+    }
+    return expected == (size_t)file_size;
+}
+
+int texture_bc_read(TextureBcImage *image, const char *png_path)
+{
+    memset(image, 0, sizeof(*image));
+
+    char path[1024];
+    snprintf(path, sizeof(path), "%s%s", png_path, TEXTURE_BC_EXTENSION);
+    FILE *file = fopen(path, "rb");
+    if (!file) {
+        return -1;
+    }
+
+    fseek(file, 0, SEEK_END);
+    long file_size = ftell(file);
+    fseek(file, 0, SEEK_SET);
+
+    int ok = file_size >= (long)sizeof(image->header) && fread(&image->header, sizeof(image->header), 1, file) == 1;
+    ok = ok && header_valid(&image->header, file_size);
+    if (!ok) {
+        printf("Invalid compressed texture: %s\n", path);
+        fclose(file);
+        return -1;
+    }
+
+    // PNG se menjao posle pecenja; bez PNG-a se koristi ono sto postoji
+    uint64_t mtime, size;
+    if (source_info(png_path, &mtime, &size) == 0 && (mtime != image->header.source_mtime || size != image->header.source_size)) {
+        printf("Compressed texture %s is stale, using PNG (make textures)\n", path);
+        fclose(file);
+        return -1;
+    }
+
+    size_t data_size = (size_t)file_size - sizeof(image->header);
+    image->data = malloc(data_size);
+    ok = image->data && fread(image->data, 1, data_size, file) == data_size;
+    fclose(file);
+    if (!ok) {
+        printf("Failed to read compressed texture: %s\n", path);
+        texture_bc_free(image);
+        return -1;
+    }
+
+    size_t offset = 0;
+    for (uint32_t level = 0; level < image->header.level_count; ++level) {
+        image->levels[level] = image->data + offset;
+        offset += image->header.level_sizes[level];
+    }
+    return 0;
+}
+
+void texture_bc_free(TextureBcImage *image)
+{
+    free(image->data);
+    memset(image, 0, sizeof(*image));
+}
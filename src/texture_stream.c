@@ -0,0 +1,383 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stb_image.h>
+#include <texture.h>
+#include <texture_stream.h>
+
+// 2x2 box filter, kao glGenerateMipmap, ali na worker niti
+static unsigned char *downsample(const unsigned char *src, int width, int height, int channels)
+{
+    int dst_width = width > 1 ? width / 2 : 1;
+    int dst_height = height > 1 ? height / 2 : 1;
+    unsigned char *dst = malloc((size_t)dst_width * dst_height * channels);
+    if (!dst) {
+        return NULL;
+    }
+
+    for (int y = 0; y < dst_height; ++y) {
+        int y0 = y * 2;
+        int y1 = y0 + 1 < height ? y0 + 1 : y0;
+        for (int x = 0; x < dst_width; ++x) {
+            int x0 = x * 2;
+            int x1 = x0 + 1 < width ? x0 + 1 : x0;
+            for (int c = 0; c < channels; ++c) {
+                int sum = src[(y0 * width + x0) * channels + c] + src[(y0 * width + x1) * channels + c] +
+                          src[(y1 * width + x0) * channels + c] + src[(y1 * width + x1) * channels + c];
+                dst[(y * dst_width + x) * channels + c] = (unsigned char)((sum + 2) / 4);
+            }
+        }
+    }
+    return dst;
+}
+
+static void decode_job(void *user)
+{
+    TextureStreamJob *job = user;
+    TextureStream *stream = job->stream;
+    TextureStreamEntry *entry = &stream->entries[job->entry];
+    int face = job->face;
+
+    TextureBcImage *compressed = &entry->compressed[face];
+    if (stream->use_compressed && !entry->png_only && texture_bc_read(compressed, entry->paths[face]) == 0) {
+        entry->widths[face] = compressed->header.width;
+        entry->heights[face] = compressed->header.height;
+        entry->channels[face] = 0;
+        for (uint32_t level = 0; level < compressed->header.level_count && level < TEXTURE_STREAM_MAX_LEVELS; ++level) {
+            entry->levels[face][level] = compressed->levels[level];
+        }
+
+        pthread_mutex_lock(&stream->mutex);
+        entry->faces_decoded++;
+        pthread_mutex_unlock(&stream->mutex);
+        return;
+    }
+
+    int width = 0, height = 0, channels = 0;
+    unsigned char *pixels = stbi_load(entry->paths[face], &width, &height, &channels, 0);
+    int failed = pixels == NULL;
+    if (failed) {
+        printf("Failed to load texture: %s\n", entry->paths[face]);
+    } else {
+        entry->levels[face][0] = pixels;
+        entry->widths[face] = width;
+        entry->heights[face] = height;
+        entry->channels[face] = channels;
+
+        // cubemap se filtrira sa GL_LINEAR, mipovi mu ne trebaju
+        int levels = entry->target != GL_TEXTURE_CUBE_MAP ? texture_mip_level_count(width, height) : 1;
+        for (int level = 1; level < levels && !failed; ++level) {
+            int w = width >> (level - 1), h = height >> (level - 1);
+            entry->levels[face][level] = downsample(entry->levels[face][level - 1], w > 0 ? w : 1, h > 0 ? h : 1, channels);
+            failed = entry->levels[face][level] == NULL;
+        }
+    }
+
+    pthread_mutex_lock(&stream->mutex);
+    entry->faces_decoded++;
+    entry->failed |= failed;
+    pthread_mutex_unlock(&stream->mutex);
+}
+
+static GLuint placeholder_create(GLenum target, const unsigned char *rgba)
+{
+    GLuint texture;
+    glGenTextures(1, &texture);
+    glBindTexture(target, texture);
+    if (target == GL_TEXTURE_2D_ARRAY) {
+        glTexImage3D(target, 0, GL_RGBA, 1, 1, 1, 0, GL_RGBA, GL_UNSIGNED_BYTE, rgba);
+    }
+    int faces = target == GL_TEXTURE_CUBE_MAP ? 6 : (target == GL_TEXTURE_2D ? 1 : 0);
+    for (int face = 0; face < faces; ++face) {
+        GLenum face_target = target == GL_TEXTURE_CUBE_MAP ? GL_TEXTURE_CUBE_MAP_POSITIVE_X + face : target;
+        glTexImage2D(face_target, 0, GL_RGBA, 1, 1, 0, GL_RGBA, GL_UNSIGNED_BYTE, rgba);
+    }
+    glTexParameteri(target, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glTexParameteri(target, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    glBindTexture(target, 0);
+    return texture;
+}
+
+void texture_stream_init(TextureStream *stream)
+{
+    memset(stream, 0, sizeof(*stream));
+    pthread_mutex_init(&stream->mutex, NULL);
+    stream->pool = thread_pool_shared();
+    stream->upload_budget_bytes = TEXTURE_STREAM_UPLOAD_BUDGET_BYTES;
+    stream->use_compressed = texture_bc_supported();
+
+    // neutralna siva za materijale, bledo plava za nebo
+    const unsigned char grey[4] = { 128, 128, 128, 255 };
+    const unsigned char sky[4] = { 150, 175, 205, 255 };
+    stream->placeholder_2d = placeholder_create(GL_TEXTURE_2D, grey);
+    stream->placeholder_cube = placeholder_create(GL_TEXTURE_CUBE_MAP, sky);
+    stream->placeholder_array = placeholder_create(GL_TEXTURE_2D_ARRAY, grey);
+
+    glGenBuffers(1, &stream->pbo);
+}
+
+static int request(TextureStream *stream, GLenum target, const char **paths, int face_count)
+{
+    if (stream->count >= TEXTURE_STREAM_MAX_TEXTURES) {
+        printf("Texture stream: no free slots for %s\n", paths[0]);
+        return -1;
+    }
+    if (face_count < 1 || face_count > TEXTURE_STREAM_MAX_LAYERS) {
+        printf("Texture stream: %d layers requested, at most %d supported\n", face_count, TEXTURE_STREAM_MAX_LAYERS);
+        return -1;
+    }
+
+    int id = stream->count++;
+    TextureStreamEntry *entry = &stream->entries[id];
+    entry->target = target;
+    entry->face_count = face_count;
+    entry->state = TEXTURE_STREAM_DECODING;
+    stream->pending++;
+    for (int face = 0; face < face_count; ++face) {
+        snprintf(entry->paths[face], TEXTURE_STREAM_PATH_LENGTH, "%s", paths[face]);
+    }
+    for (int face = 0; face < face_count; ++face) {
+        entry->jobs[face].stream = stream;
+        entry->jobs[face].entry = id;
+        entry->jobs[face].face = face;
+        thread_pool_submit(stream->pool, &stream->jobs, decode_job, &entry->jobs[face]);
+    }
+    return id;
+}
+
+int texture_stream_request(TextureStream *stream, const char *path)
+{
+    return request(stream, GL_TEXTURE_2D, &path, 1);
+}
+
+int texture_stream_request_cubemap(TextureStream *stream, const char **faces)
+{
+    return request(stream, GL_TEXTURE_CUBE_MAP, faces, 6);
+}
+
+int texture_stream_request_array(TextureStream *stream, const char **paths, int count)
+{
+    return request(stream, GL_TEXTURE_2D_ARRAY, paths, count);
+}
+
+static void entry_free_levels(TextureStreamEntry *entry)
+{
+    for (int face = 0; face < entry->face_count; ++face) {
+        if (entry->compressed[face].data) {
+            texture_bc_free(&entry->compressed[face]);
+            memset(entry->levels[face], 0, sizeof(entry->levels[face]));
+            continue;
+        }
+        for (int level = 0; level < TEXTURE_STREAM_MAX_LEVELS; ++level) {
+            // nivo 0 je iz stbi_load
+            if (level == 0) {
+                stbi_image_free(entry->levels[face][0]);
+            } else {
+                free(entry->levels[face][level]);
+            }
+            entry->levels[face][level] = NULL;
+        }
+    }
+}
+
+// neke strane su iz .rtex-a, ali ne mogu sve zajedno kompresovane (isto pravilo kao texture_load_array)
+static int entry_formats_mixed(const TextureStreamEntry *entry)
+{
+    for (int face = 0; face < entry->face_count; ++face) {
+        if (entry->compressed[face].data) {
+            return !texture_bc_faces_usable(entry->compressed, entry->face_count);
+        }
+    }
+    return 0;
+}
+
+// baci BC podatke i dekodiraj sve strane ponovo iz PNG-ova
+static void entry_redecode_png(TextureStream *stream, TextureStreamEntry *entry)
+{
+    entry_free_levels(entry);
+    entry->png_only = 1;
+    pthread_mutex_lock(&stream->mutex);
+    entry->faces_decoded = 0;
+    pthread_mutex_unlock(&stream->mutex);
+    for (int face = 0; face < entry->face_count; ++face) {
+        thread_pool_submit(stream->pool, &stream->jobs, decode_job, &entry->jobs[face]);
+    }
+}
+
+// sve strane su dekodirane: proveri ih i napravi storage za sve nivoe
+static int entry_begin_upload(TextureStreamEntry *entry)
+{
+    if (!texture_faces_match(entry->widths, entry->heights, entry->channels, entry->face_count)) {
+        printf("Texture stream: faces/layers of %s differ in size or channels\n", entry->paths[0]);
+        return -1;
+    }
+    uint32_t bc_format = entry->compressed[0].header.format;
+
+    int width = entry->widths[0], height = entry->heights[0];
+    entry->level_count = entry->target != GL_TEXTURE_CUBE_MAP ? texture_mip_level_count(width, height) : 1;
+    if (bc_format && entry->level_count > (int)entry->compressed[0].header.level_count) {
+        entry->level_count = entry->compressed[0].header.level_count;
+    }
+    entry->compressed_format = texture_bc_gl_format(bc_format);
+    entry->texture = texture_storage_create(entry->target, bc_format, entry->channels[0], width, height,
+                                            entry->face_count, entry->level_count);
+    glBindTexture(entry->target, 0);
+
+    entry->upload_face = 0;
+    entry->upload_level = 0;
+    entry->upload_row = 0;
+    entry->state = TEXTURE_STREAM_UPLOADING;
+    return 0;
+}
+
+// salje trake dok ne potrosi budzet, vraca potrosene bajtove; prva traka frejma uvek prolazi
+// kod kompresovanih tekstura je red jedan red 4x4 blokova
+static int entry_upload(TextureStream *stream, TextureStreamEntry *entry, int budget, int uploaded)
+{
+    int spent = 0;
+    int channels = entry->channels[0];
+    uint32_t bc_format = entry->compressed[0].header.format;
+
+    glBindTexture(entry->target, entry->texture);
+    while (entry->upload_face < entry->face_count) {
+        int face = entry->upload_face, level = entry->upload_level;
+        int width = entry->widths[0] >> level, height = entry->heights[0] >> level;
+        width = width > 0 ? width : 1;
+        height = height > 0 ? height : 1;
+        int row_bytes = width * channels;
+        int row_count = height;
+        if (entry->compressed_format) {
+            row_bytes = (width + 3) / 4 * texture_bc_block_bytes(bc_format);
+            row_count = (height + 3) / 4;
+        }
+
+        int rows = (budget - spent) / row_bytes;
+        if (rows < 1) {
+            if (uploaded + spent > 0) {
+                break;
+            }
+            rows = 1;
+        }
+        if (rows > row_count - entry->upload_row) {
+            rows = row_count - entry->upload_row;
+        }
+        int bytes = rows * row_bytes;
+
+        // orphan: novi storage za PBO, prethodna traka se jos moze citati
+        int pbo_size = bytes > stream->upload_budget_bytes ? bytes : stream->upload_budget_bytes;
+        glBufferData(GL_PIXEL_UNPACK_BUFFER, pbo_size, NULL, GL_STREAM_DRAW);
+        void *mapped = glMapBufferRange(GL_PIXEL_UNPACK_BUFFER, 0, bytes, GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT);
+        if (mapped) {
+            memcpy(mapped, entry->levels[face][level] + (size_t)entry->upload_row * row_bytes, bytes);
+            glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER);
+            // poslednja traka blokova moze biti niza od 4 piksela samo ako dodiruje ivicu nivoa
+            int y = entry->compressed_format ? entry->upload_row * 4 : entry->upload_row;
+            int h = entry->compressed_format ? (rows * 4 < height - y ? rows * 4 : height - y) : rows;
+            texture_upload_rows(entry->target, face, level, y, width, h, bc_format, channels, bytes, (void *)0);
+        }
+        spent += bytes;
+
+        entry->upload_row += rows;
+        if (entry->upload_row >= row_count) {
+            entry->upload_row = 0;
+            if (++entry->upload_level >= entry->level_count) {
+                entry->upload_level = 0;
+                entry->upload_face++;
+            }
+        }
+        if (spent >= budget) {
+            break;
+        }
+    }
+    glBindTexture(entry->target, 0);
+
+    if (entry->upload_face >= entry->face_count) {
+        entry_free_levels(entry);
+        entry->state = TEXTURE_STREAM_RESIDENT;
+        stream->pending--;
+    }
+    return spent;
+}
+
+void texture_stream_update(TextureStream *stream)
+{
+    stream->uploaded_last_frame = 0;
+    if (stream->pending == 0) {
+        return;
+    }
+
+    int budget = stream->upload_budget_bytes;
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, stream->pbo);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+
+    // redom kojim su trazene, da prvi zahtevi ne cekaju na kasnije
+    for (int i = 0; i < stream->count && stream->uploaded_last_frame < budget; ++i) {
+        TextureStreamEntry *entry = &stream->entries[i];
+        if (entry->state == TEXTURE_STREAM_DECODING) {
+            pthread_mutex_lock(&stream->mutex);
+            int done = entry->faces_decoded == entry->face_count;
+            int failed = entry->failed;
+            pthread_mutex_unlock(&stream->mutex);
+            if (!done) {
+                continue;
+            }
+            if (!failed && !entry->png_only && entry_formats_mixed(entry)) {
+                entry_redecode_png(stream, entry);
+                continue;
+            }
+            // storage se pravi bez PBO-a, inace bi NULL bio offset u njega
+            glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+            int begun = !failed && entry_begin_upload(entry) == 0;
+            glBindBuffer(GL_PIXEL_UNPACK_BUFFER, stream->pbo);
+            if (!begun) {
+                entry_free_levels(entry);
+                entry->state = TEXTURE_STREAM_FAILED;
+                stream->pending--;
+                continue;
+            }
+        }
+        if (entry->state == TEXTURE_STREAM_UPLOADING) {
+            stream->uploaded_last_frame += entry_upload(stream, entry, budget - stream->uploaded_last_frame,
+                                                        stream->uploaded_last_frame);
+        }
+    }
+
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+}
+
+GLuint texture_stream_get(const TextureStream *stream, int id)
+{
+    if (id < 0 || id >= stream->count) {
+        return stream->placeholder_2d;
+    }
+    const TextureStreamEntry *entry = &stream->entries[id];
+    if (entry->state == TEXTURE_STREAM_RESIDENT) {
+        return entry->texture;
+    }
+    switch (entry->target) {
+        case GL_TEXTURE_CUBE_MAP: return stream->placeholder_cube;
+        case GL_TEXTURE_2D_ARRAY: return stream->placeholder_array;
+        default: return stream->placeholder_2d;
+    }
+}
+
+void texture_stream_cleanup(TextureStream *stream)
+{
+    // worker niti jos mogu da pisu u entry-je
+    thread_pool_wait(stream->pool, &stream->jobs);
+    for (int i = 0; i < stream->count; ++i) {
+        TextureStreamEntry *entry = &stream->entries[i];
+        entry_free_levels(entry);
+        if (entry->texture) {
+            glDeleteTextures(1, &entry->texture);
+        }
+    }
+    glDeleteTextures(1, &stream->placeholder_2d);
+    glDeleteTextures(1, &stream->placeholder_cube);
+    glDeleteTextures(1, &stream->placeholder_array);
+    glDeleteBuffers(1, &stream->pbo);
+    pthread_mutex_destroy(&stream->mutex);
+    stream->count = 0;
+    stream->pending = 0;
+}
@@ -0,0 +1,244 @@
+#include <thread_pool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+// koliko traka po niti, vise traka = bolji balans kad su redovi nejednako skupi
+#define BANDS_PER_THREAD 4
+
+static ThreadPool shared_pool;
+static pthread_mutex_t shared_lock = PTHREAD_MUTEX_INITIALIZER;
+static int shared_ready = 0;
+
+static int hardware_thread_count(void) {
+    long count = sysconf(_SC_NPROCESSORS_ONLN);
+    return count > 0 ? (int)count : 1;
+}
+
+static void run_job(ThreadPool *pool, ThreadPoolJob *job) {
+    job->fn(job->user);
+
+    pthread_mutex_lock(&pool->mutex);
+    if (job->group) {
+        job->group->pending--;
+    }
+    pthread_cond_broadcast(&pool->done_cond);
+    pthread_mutex_unlock(&pool->mutex);
+
+    free(job);
+}
+
+// poziva se sa zakljucanim mutexom
+static ThreadPoolJob *pop_job(ThreadPool *pool) {
+    ThreadPoolJob *job = pool->head;
+    if (job) {
+        pool->head = job->next;
+        if (!pool->head) {
+            pool->tail = NULL;
+        }
+    }
+    return job;
+}
+
+static void *worker_main(void *arg) {
+    ThreadPool *pool = arg;
+    for (;;) {
+        pthread_mutex_lock(&pool->mutex);
+        while (!pool->head && !pool->shutting_down) {
+            pthread_cond_wait(&pool->work_cond, &pool->mutex);
+        }
+        if (!pool->head && pool->shutting_down) {
+            pthread_mutex_unlock(&pool->mutex);
+            return NULL;
+        }
+        ThreadPoolJob *job = pop_job(pool);
+        pthread_mutex_unlock(&pool->mutex);
+
+        run_job(pool, job);
+    }
+}
+
+void thread_pool_init(ThreadPool *pool, int thread_count) {
+    if (thread_count < 0) {
+        thread_count = hardware_thread_count() - 1;
+    }
+
+    pool->threads = NULL;
+    pool->thread_count = 0;
+    pool->head = NULL;
+    pool->tail = NULL;
+    pool->shutting_down = 0;
+    pthread_mutex_init(&pool->mutex, NULL);
+    pthread_cond_init(&pool->work_cond, NULL);
+    pthread_cond_init(&pool->done_cond, NULL);
+
+    if (thread_count <= 0) {
+        return;
+    }
+
+    pool->threads = malloc(thread_count * sizeof(pthread_t));
+    if (!pool->threads) {
+        fprintf(stderr, "Thread pool: failed to allocate %d threads, running inline\n", thread_count);
+        return;
+    }
+
+    for (int i = 0; i < thread_count; i++) {
+        if (pthread_create(&pool->threads[i], NULL, worker_main, pool) != 0) {
+            fprintf(stderr, "Thread pool: failed to start worker %d\n", i);
+            break;
+        }
+        pool->thread_count++;
+    }
+}
+
+void thread_pool_cleanup(ThreadPool *pool) {
+    pthread_mutex_lock(&pool->mutex);
+    pool->shutting_down = 1;
+    pthread_cond_broadcast(&pool->work_cond);
+    pthread_mutex_unlock(&pool->mutex);
+
+    for (int i = 0; i < pool->thread_count; i++) {
+        pthread_join(pool->threads[i], NULL);
+    }
+    free(pool->threads);
+    pool->threads = NULL;
+    pool->thread_count = 0;
+
+    // poslovi koji nisu stigli da se izvrse
+    ThreadPoolJob *job;
+    while ((job = pop_job(pool)) != NULL) {
+        job->fn(job->user);
+        free(job);
+    }
+
+    pthread_mutex_destroy(&pool->mutex);
+    pthread_cond_destroy(&pool->work_cond);
+    pthread_cond_destroy(&pool->done_cond);
+}
+
+void thread_pool_submit(ThreadPool *pool, ThreadPoolGroup *group, ThreadPoolJobFn fn, void *user) {
+    if (!pool || pool->thread_count == 0) {
+        fn(user);
+        return;
+    }
+
+    ThreadPoolJob *job = malloc(sizeof(ThreadPoolJob));
+    if (!job) {
+        fn(user);
+        return;
+    }
+    job->fn = fn;
+    job->user = user;
+    job->group = group;
+    job->next = NULL;
+
+    pthread_mutex_lock(&pool->mutex);
+    if (group) {
+        group->pending++;
+    }
+    if (pool->tail) {
+        pool->tail->next = job;
+    } else {
+        pool->head = job;
+    }
+    pool->tail = job;
+    pthread_cond_signal(&pool->work_cond);
+    pthread_mutex_unlock(&pool->mutex);
+}
+
+void thread_pool_wait(ThreadPool *pool, ThreadPoolGroup *group) {
+    if (!pool || pool->thread_count == 0) {
+        return;
+    }
+
+    pthread_mutex_lock(&pool->mutex);
+    while (group->pending > 0) {
+        ThreadPoolJob *job = pop_job(pool);
+        if (job) {
+            pthread_mutex_unlock(&pool->mutex);
+            run_job(pool, job);
+            pthread_mutex_lock(&pool->mutex);
+        } else {
+            pthread_cond_wait(&pool->done_cond, &pool->mutex);
+        }
+    }
+    pthread_mutex_unlock(&pool->mutex);
+}
+
+typedef struct {
+    ThreadPoolRangeFn fn;
+    void *user;
+    int begin;
+    int end;
+} RangeJob;
+
+static void range_job_run(void *arg) {
+    RangeJob *job = arg;
+    job->fn(job->user, job->begin, job->end);
+}
+
+void thread_pool_parallel_for(ThreadPool *pool, int count, ThreadPoolRangeFn fn, void *user) {
+    if (count <= 0) {
+        return;
+    }
+    if (!pool || pool->thread_count == 0) {
+        fn(user, 0, count);
+        return;
+    }
+
+    int band_count = (pool->thread_count + 1) * BANDS_PER_THREAD;
+    if (band_count > count) {
+        band_count = count;
+    }
+
+    RangeJob *jobs = malloc(band_count * sizeof(RangeJob));
+    if (!jobs) {
+        fn(user, 0, count);
+        return;
+    }
+
+    ThreadPoolGroup group = { 0 };
+    for (int i = 0; i < band_count; i++) {
+        jobs[i].fn = fn;
+        jobs[i].user = user;
+        jobs[i].begin = (int)((long long)count * i / band_count);
+        jobs[i].end = (int)((long long)count * (i + 1) / band_count);
+    }
+    // prva traka ide na pozivaoca, ostale u red
+    for (int i = 1; i < band_count; i++) {
+        thread_pool_submit(pool, &group, range_job_run, &jobs[i]);
+    }
+    range_job_run(&jobs[0]);
+    thread_pool_wait(pool, &group);
+
+    free(jobs);
+}
+
+static void shared_pool_create(void) {
+    int thread_count = -1;
+    const char *env = getenv("TERRAIN_THREADS");
+    if (env && atoi(env) > 0) {
+        thread_count = atoi(env) - 1;
+    }
+    thread_pool_init(&shared_pool, thread_count);
+    shared_ready = 1;
+    printf("Thread pool: %d worker threads\n", shared_pool.thread_count);
+}
+
+ThreadPool *thread_pool_shared(void) {
+    pthread_mutex_lock(&shared_lock);
+    if (!shared_ready) {
+        shared_pool_create();
+    }
+    pthread_mutex_unlock(&shared_lock);
+    return &shared_pool;
+}
+
+void thread_pool_shared_shutdown(void) {
+    pthread_mutex_lock(&shared_lock);
+    if (shared_ready) {
+        thread_pool_cleanup(&shared_pool);
+        shared_ready = 0;
+    }
+    pthread_mutex_unlock(&shared_lock);
+}
@@ -2,10 +2,10 @@
 #include <stdlib.h>
 #include <string.h>
 #include <stdio.h>
-#include <time.h>
 #include <math.h>
+#include <stddef.h>
 
-static void tree_instance_build(TreeInstance *instance, vec3_t position, float scale, float rotation_rad)
+static void tree_instance_build(TreeInstance *instance, TreeBounds *bounds, const rafgl_meshPUN_t *mesh, vec3_t position, float scale, float rotation_rad)
 {
     mat4_t translate = m4_translation(position);
     mat4_t rotate = m4_rotation_y(rotation_rad);
@@ -25,19 +25,14 @@ static void tree_instance_build(TreeInstance *instance, vec3_t position, float s
 
     instance->leaf_start_height = position.y + 1.6f * scale;
     instance->leaf_transition_height = 0.9f * scale;
-}
-
-// helperi
-static float random_unit(void)
-{
-    return (float)rand() / (float)RAND_MAX;
-}
 
-static float random_range(float min_value, float max_value)
-{
-    return min_value + random_unit() * (max_value - min_value);
+    // rotacija oko y ne menja poluprecnik sfere oko AABB-a mesha
+    vec3_t local_center = v3_muls(v3_add(mesh->bounds_min, mesh->bounds_max), 0.5f);
+    bounds->center = m4_mul_pos(instance->model, local_center);
+    bounds->radius = v3_length(v3_sub(mesh->bounds_max, local_center)) * scale;
 }
 
+// helperi
 static float clampf(float value, float min_value, float max_value)
 {
     if(value < min_value)
@@ -90,39 +85,69 @@ static int is_grass_candidate(const Vertex *vertex, const Terrain *terrain)
     return slope <= max_slope;
 }
 
-static void seed_random_generator(void)
+// instance atributi VAO-a citaju iz VBO-a datog pogleda
+static void tree_instance_attributes_bind(TreeSystem *system, int view)
 {
-    static int seeded = 0;
-    if(!seeded)
+    glBindVertexArray(system->mesh.vao_id);
+    glBindBuffer(GL_ARRAY_BUFFER, system->views[view].instance_vbo);
+
+    // atributi 0-2 su vec mesh (pozicija, uv, normala), instance idu od 3
+    const GLsizei stride = sizeof(TreeInstance);
+    for(int column = 0; column < 4; ++column)
     {
-        srand((unsigned)time(NULL));
-        seeded = 1;
+        GLuint location = 3 + column;
+        glEnableVertexAttribArray(location);
+        glVertexAttribPointer(location, 4, GL_FLOAT, GL_FALSE, stride,
+                              (void*)(offsetof(TreeInstance, model) + column * 4 * sizeof(float)));
+        glVertexAttribDivisor(location, 1);
     }
+    for(int column = 0; column < 3; ++column)
+    {
+        GLuint location = 7 + column;
+        glEnableVertexAttribArray(location);
+        glVertexAttribPointer(location, 3, GL_FLOAT, GL_FALSE, stride,
+                              (void*)(offsetof(TreeInstance, normal_matrix) + column * 3 * sizeof(float)));
+        glVertexAttribDivisor(location, 1);
+    }
+    glEnableVertexAttribArray(10);
+    glVertexAttribPointer(10, 2, GL_FLOAT, GL_FALSE, stride, (void*)offsetof(TreeInstance, leaf_start_height));
+    glVertexAttribDivisor(10, 1);
+
+    glBindVertexArray(0);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    system->bound_view = view;
 }
 
-void tree_system_init(TreeSystem *system, const Terrain *terrain)
+static void tree_instance_buffer_create(TreeSystem *system)
+{
+    // storage dobijaju pri prvom uploadu, pogledi koji se ne koriste ne zauzimaju memoriju
+    for(int view = 0; view < TREE_VIEW_COUNT; ++view)
+    {
+        glGenBuffers(1, &system->views[view].instance_vbo);
+    }
+    tree_instance_attributes_bind(system, TREE_VIEW_CAMERA);
+}
+
+void tree_system_load_mesh(TreeSystem *system)
 {
     memset(system, 0, sizeof(*system));
-    seed_random_generator();
 
     rafgl_meshPUN_init(&system->mesh);
     vec3_t mesh_offset = vec3(0.0f, 1.9f, 0.0f);
-    rafgl_meshPUN_load_from_OBJ_offset(&system->mesh, "res/models/tree.obj", mesh_offset);
-
-    system->program = rafgl_program_create_from_name("tree");
-    system->u_mvp_loc = glGetUniformLocation(system->program, "u_MVP");
-    system->u_model_loc = glGetUniformLocation(system->program, "u_model");
-    system->u_normal_loc = glGetUniformLocation(system->program, "u_normal_matrix");
-    system->u_light_dir_loc = glGetUniformLocation(system->program, "u_light_dir");
-    system->u_light_color_loc = glGetUniformLocation(system->program, "u_light_color");
-    system->u_ambient_color_loc = glGetUniformLocation(system->program, "u_ambient_color");
-    system->u_trunk_color_loc = glGetUniformLocation(system->program, "u_trunk_color");
-    system->u_leaf_color_loc = glGetUniformLocation(system->program, "u_leaf_color");
-    system->u_leaf_start_loc = glGetUniformLocation(system->program, "u_leaf_start_height");
-    system->u_leaf_transition_loc = glGetUniformLocation(system->program, "u_leaf_transition_height");
+    if(rafgl_meshPUN_read_OBJ(&system->mesh, "res/models/tree.obj", mesh_offset,
+                              &system->mesh_vertices, &system->mesh_indices) != 0)
+    {
+        fprintf(stderr, "Tree system: failed to load res/models/tree.obj\n");
+        system->mesh_vertices = NULL;
+        system->mesh_indices = NULL;
+    }
+}
 
-    system->trunk_color = vec3(0.36f, 0.22f, 0.08f);
-    system->leaf_color = vec3(0.20f, 0.55f, 0.18f);
+void tree_system_place(TreeSystem *system, const Terrain *terrain, uint32_t seed)
+{
+    // poseban stream da raspored drveca ne zavisi od permutacije suma
+    NoiseRng rng;
+    noise_rng_seed(&rng, seed, 0x74726565ULL);
 
     int vertex_grid = terrain->size * terrain->size;
     if(vertex_grid <= 0)
@@ -133,10 +158,9 @@ void tree_system_init(TreeSystem *system, const Terrain *terrain)
     const float tree_density = 0.03f;
     system->instance_count = (int)(vertex_grid * tree_density);
 
-    const int max_tree_instances = 300;
-    if(system->instance_count > max_tree_instances)
+    if(system->instance_count > TREE_MAX_INSTANCES)
     {
-        system->instance_count = max_tree_instances;
+        system->instance_count = TREE_MAX_INSTANCES;
     }
 
     int *candidate_indices = malloc(vertex_grid * sizeof(int));
@@ -153,11 +177,10 @@ void tree_system_init(TreeSystem *system, const Terrain *terrain)
     {
         for(int col = 0; col < terrain->size; ++col)
         {
-            int vertex_index = row * terrain->size + col;
-            Vertex *vertex = &terrain->vertices[vertex_index];
-            if(is_grass_candidate(vertex, terrain))
+            Vertex vertex = terrain_grid_vertex(terrain, row, col);
+            if(is_grass_candidate(&vertex, terrain))
             {
-                candidate_indices[candidate_count++] = vertex_index;
+                candidate_indices[candidate_count++] = row * terrain->size + col;
             }
         }
     }
@@ -177,14 +200,16 @@ void tree_system_init(TreeSystem *system, const Terrain *terrain)
 
     for(int i = candidate_count - 1; i > 0; --i)
     {
-        int j = rand() % (i + 1);
+        int j = noise_rng_below(&rng, i + 1);
         int tmp = candidate_indices[i];
         candidate_indices[i] = candidate_indices[j];
         candidate_indices[j] = tmp;
     }
 
     system->instances = calloc(system->instance_count, sizeof(TreeInstance));
-    if(!system->instances)
+    system->bounds = calloc(system->instance_count, sizeof(TreeBounds));
+    system->visible = malloc(system->instance_count * sizeof(TreeInstance));
+    if(!system->instances || !system->bounds || !system->visible)
     {
         fprintf(stderr, "Tree system: failed to allocate instance buffer\n");
         free(candidate_indices);
@@ -195,20 +220,60 @@ void tree_system_init(TreeSystem *system, const Terrain *terrain)
     for(int i = 0; i < system->instance_count; ++i)
     {
         int vertex_index = candidate_indices[i];
-        Vertex anchor = terrain->vertices[vertex_index];
+        Vertex anchor = terrain_grid_vertex(terrain, vertex_index / terrain->size, vertex_index % terrain->size);
         vec3_t tree_pos = vec3(anchor.x, anchor.y, anchor.z);
-        float scale = random_range(1.4f, 2.6f);
-        float rotation_rad = random_range(0.0f, 2.0f * M_PIf);
-        tree_instance_build(&system->instances[i], tree_pos, scale, rotation_rad);
+        float scale = noise_rng_range(&rng, 1.4f, 2.6f);
+        float rotation_rad = noise_rng_range(&rng, 0.0f, 2.0f * M_PIf);
+        tree_instance_build(&system->instances[i], &system->bounds[i], &system->mesh, tree_pos, scale, rotation_rad);
     }
 
     free(candidate_indices);
+}
+
+void tree_system_upload(TreeSystem *system)
+{
+    if(system->mesh_vertices)
+    {
+        rafgl_meshPUN_upload(&system->mesh, system->mesh_vertices, system->mesh_indices);
+        free(system->mesh_vertices);
+        free(system->mesh_indices);
+        system->mesh_vertices = NULL;
+        system->mesh_indices = NULL;
+    }
+
+    system->program = rafgl_program_create_from_name("tree");
+    system->u_view_projection_loc = glGetUniformLocation(system->program, "u_view_projection");
+    system->u_light_dir_loc = glGetUniformLocation(system->program, "u_light_dir");
+    system->u_light_color_loc = glGetUniformLocation(system->program, "u_light_color");
+    system->u_ambient_color_loc = glGetUniformLocation(system->program, "u_ambient_color");
+    system->u_trunk_color_loc = glGetUniformLocation(system->program, "u_trunk_color");
+    system->u_leaf_color_loc = glGetUniformLocation(system->program, "u_leaf_color");
+    system->u_depth_only_loc = glGetUniformLocation(system->program, "u_depth_only");
+    system->u_overdraw_loc = glGetUniformLocation(system->program, "u_overdraw");
+    shadow_map_get_uniforms(system->program, &system->shadow_uniforms);
 
-    printf("Tree system initialized with %d trees\n", system->instance_count);
+    system->trunk_color = vec3(0.36f, 0.22f, 0.08f);
+    system->leaf_color = vec3(0.20f, 0.55f, 0.18f);
+
+    if(system->mesh.loaded)
+    {
+        tree_instance_buffer_create(system);
+    }
+
+    printf("Tree system initialized with %d trees (%u vertices, %u indices per tree)\n",
+           system->instance_count, system->mesh.vertex_count, system->mesh.index_count);
+}
+
+void tree_system_init(TreeSystem *system, const Terrain *terrain, uint32_t seed)
+{
+    tree_system_load_mesh(system);
+    tree_system_place(system, terrain, seed);
+    tree_system_upload(system);
 }
 
-void tree_system_render(TreeSystem *system, mat4_t view_projection, vec3_t light_dir, vec3_t light_color, vec3_t ambient_color)
+void tree_system_render(TreeSystem *system, int view, mat4_t view_projection, const Frustum *frustum, vec3_t light_dir, vec3_t light_color, vec3_t ambient_color)
 {
+    cull_counter_reset(&system->cull);
     if(!system->mesh.loaded || !system->program || system->instance_count <= 0)
     {
         return;
@@ -220,18 +285,53 @@ void tree_system_render(TreeSystem *system, mat4_t view_projection, vec3_t light
     glUniform3f(system->u_ambient_color_loc, ambient_color.x, ambient_color.y, ambient_color.z);
     glUniform3f(system->u_trunk_color_loc, system->trunk_color.x, system->trunk_color.y, system->trunk_color.z);
     glUniform3f(system->u_leaf_color_loc, system->leaf_color.x, system->leaf_color.y, system->leaf_color.z);
+    glUniform1i(system->u_depth_only_loc, system->depth_only);
+    glUniform1i(system->u_overdraw_loc, system->overdraw);
+    shadow_map_bind(system->shadow, &system->shadow_uniforms, SHADOW_TEXTURE_UNIT);
 
-    glBindVertexArray(system->mesh.vao_id);
-    for(int i = 0; i < system->instance_count; ++i)
+    // isti vidljivi skup kao prosli frejm ovog pogleda, buffer vec ima tacne instance
+    TreeView *tree_view = &system->views[view];
+    if(!tree_view->valid || memcmp(&view_projection, &tree_view->last_view_projection, sizeof(mat4_t)) != 0)
     {
-        TreeInstance *instance = &system->instances[i];
-        mat4_t model_mvp = m4_mul(view_projection, instance->model);
-        glUniformMatrix4fv(system->u_mvp_loc, 1, GL_FALSE, &model_mvp.m[0][0]);
-        glUniformMatrix4fv(system->u_model_loc, 1, GL_FALSE, &instance->model.m[0][0]);
-        glUniformMatrix3fv(system->u_normal_loc, 1, GL_FALSE, instance->normal_matrix);
-        glUniform1f(system->u_leaf_start_loc, instance->leaf_start_height);
-        glUniform1f(system->u_leaf_transition_loc, instance->leaf_transition_height);
-        glDrawArrays(GL_TRIANGLES, 0, system->mesh.vertex_count);
+        int visible_count = 0;
+        for(int i = 0; i < system->instance_count; ++i)
+        {
+            const TreeBounds *bounds = &system->bounds[i];
+            if(frustum_test_sphere(frustum, bounds->center, bounds->radius))
+            {
+                system->visible[visible_count++] = system->instances[i];
+            }
+        }
+        tree_view->visible_count = visible_count;
+
+        // orphan pa upis samo vidljivih, drajver ne ceka prosli frejm
+        glBindBuffer(GL_ARRAY_BUFFER, tree_view->instance_vbo);
+        glBufferData(GL_ARRAY_BUFFER, system->instance_count * sizeof(TreeInstance), NULL, GL_STREAM_DRAW);
+        glBufferSubData(GL_ARRAY_BUFFER, 0, visible_count * sizeof(TreeInstance), system->visible);
+        glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+        tree_view->last_view_projection = view_projection;
+        tree_view->valid = 1;
+    }
+    system->cull.drawn = tree_view->visible_count;
+    system->cull.culled = system->instance_count - tree_view->visible_count;
+
+    if(tree_view->visible_count > 0)
+    {
+        if(system->bound_view != view)
+        {
+            tree_instance_attributes_bind(system, view);
+        }
+        glUniformMatrix4fv(system->u_view_projection_loc, 1, GL_FALSE, &view_projection.m[0][0]);
+        glBindVertexArray(system->mesh.vao_id);
+        if(system->mesh.indexed)
+        {
+            glDrawElementsInstanced(GL_TRIANGLES, system->mesh.index_count, GL_UNSIGNED_INT, 0, tree_view->visible_count);
+        }
+        else
+        {
+            glDrawArraysInstanced(GL_TRIANGLES, 0, system->mesh.vertex_count, tree_view->visible_count);
+        }
     }
 
     glBindVertexArray(0);
@@ -253,7 +353,21 @@ void tree_system_cleanup(TreeSystem *system)
         system->program = 0;
     }
 
+    for(int view = 0; view < TREE_VIEW_COUNT; ++view)
+    {
+        if(system->views[view].instance_vbo)
+        {
+            glDeleteBuffers(1, &system->views[view].instance_vbo);
+        }
+    }
+    memset(system->views, 0, sizeof(system->views));
+    system->bound_view = -1;
+
     free(system->instances);
     system->instances = NULL;
+    free(system->bounds);
+    system->bounds = NULL;
+    free(system->visible);
+    system->visible = NULL;
     system->instance_count = 0;
 }
@@ -45,13 +45,30 @@ void water_init(Water *water, float extent, float height)
     glUseProgram(0);
 }
 
-void water_render(Water *water, mat4_t view_projection, GLuint skybox_texture, vec3_t camera_pos)
+void water_set_center(Water *water, float x, float z)
 {
+    water->model = m4_translation(vec3(x, water->height, z));
+}
+
+void water_render(Water *water, mat4_t view_projection, const Frustum *frustum, GLuint skybox_texture, vec3_t camera_pos)
+{
+    cull_counter_reset(&water->cull);
     if(!water->program)
     {
         return;
     }
 
+    // ravan je u model matrici samo pomerena, pa je AABB centar +- extent/2
+    float half = water->extent * 0.5f;
+    vec3_t center = vec3(water->model.m30, water->model.m31, water->model.m32);
+    if(!frustum_test_aabb(frustum, vec3(center.x - half, center.y, center.z - half),
+                          vec3(center.x + half, center.y, center.z + half)))
+    {
+        water->cull.culled++;
+        return;
+    }
+    water->cull.drawn++;
+
     glEnable(GL_BLEND);
     glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
     glDepthMask(GL_FALSE);
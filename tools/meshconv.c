@@ -0,0 +1,46 @@
+#include <stdio.h>
+#include <string.h>
+
+#include <glad/glad.h>
+#include <GLFW/glfw3.h>
+
+#define RAFGL_IMPLEMENTATION
+#include <rafgl.h>
+
+// pretvara OBJ u binarni mesh koji rafgl_meshPUN_load_from_OBJ_offset ucitava bez parsiranja
+// upotreba: meshconv model.obj [model2.obj ...]   -> model.obj.rmesh
+//           meshconv -o izlaz.rmesh model.obj
+int main(int argc, char *argv[])
+{
+    if (argc < 2) {
+        fprintf(stderr, "usage: %s [-o output] model.obj [model.obj ...]\n", argv[0]);
+        return 1;
+    }
+
+    const char *output = NULL;
+    int failed = 0;
+
+    for (int i = 1; i < argc; ++i) {
+        if (strcmp(argv[i], "-o") == 0 && i + 1 < argc) {
+            output = argv[++i];
+            continue;
+        }
+
+        char cache_path[1024];
+        if (output) {
+            snprintf(cache_path, sizeof(cache_path), "%s", output);
+            output = NULL;
+        } else {
+            snprintf(cache_path, sizeof(cache_path), "%s%s", argv[i], RAFGL_MESH_CACHE_EXTENSION);
+        }
+
+        if (rafgl_meshPUN_build_cache(argv[i], cache_path) != 0) {
+            fprintf(stderr, "meshconv: failed to convert %s\n", argv[i]);
+            failed = 1;
+            continue;
+        }
+        printf("%s -> %s\n", argv[i], cache_path);
+    }
+
+    return failed;
+}
@@ -0,0 +1,53 @@
+#include <stdio.h>
+#include <string.h>
+
+#include <glad/glad.h>
+#include <GLFW/glfw3.h>
+
+#define RAFGL_IMPLEMENTATION
+#include <rafgl.h>
+
+#include <texture_bc.h>
+
+// pretvara PNG u blok-kompresovanu teksturu sa mipovima koju texture_load i texture_stream uploaduju direktno
+// upotreba: texconv [--bc1|--bc3|--bc5] slika.png [slika2.png ...]   -> slika.png.rtex
+//           texconv -o izlaz.rtex slika.png
+int main(int argc, char *argv[])
+{
+    if (argc < 2) {
+        fprintf(stderr, "usage: %s [--bc1|--bc3|--bc5] [-o output] image.png [image.png ...]\n", argv[0]);
+        return 1;
+    }
+
+    const char *output = NULL;
+    TextureBcFormat format = TEXTURE_BC_AUTO;
+    int failed = 0;
+
+    for (int i = 1; i < argc; ++i) {
+        if (strcmp(argv[i], "-o") == 0 && i + 1 < argc) {
+            output = argv[++i];
+            continue;
+        }
+        if (strcmp(argv[i], "--bc1") == 0 || strcmp(argv[i], "--bc3") == 0 || strcmp(argv[i], "--bc5") == 0) {
+            format = (TextureBcFormat)(argv[i][4] - '0');
+            continue;
+        }
+
+        char output_path[1024];
+        if (output) {
+            snprintf(output_path, sizeof(output_path), "%s", output);
+            output = NULL;
+        } else {
+            snprintf(output_path, sizeof(output_path), "%s%s", argv[i], TEXTURE_BC_EXTENSION);
+        }
+
+        if (texture_bc_bake(argv[i], output_path, format) != 0) {
+            fprintf(stderr, "texconv: failed to convert %s\n", argv[i]);
+            failed = 1;
+            continue;
+        }
+        printf("%s -> %s\n", argv[i], output_path);
+    }
+
+    return failed;
+}